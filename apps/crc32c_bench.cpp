@@ -0,0 +1,101 @@
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/crc32c.h"
+
+DEFINE_uint64(totalmb, 1024,
+              "How much data (in MB) to checksum for every buffer size");
+DEFINE_string(sizes, "64,512,4096,65536,1048576",
+              "Comma-separated buffer sizes (in bytes) to checksum");
+
+using replicated_splinterdb::crc32c;
+using replicated_splinterdb::crc32c_is_hardware_accelerated;
+using replicated_splinterdb::crc32c_portable;
+
+using crc_function = uint32_t (*)(const void*, size_t, uint32_t);
+
+static std::vector<size_t> parse_sizes(const std::string& str) {
+    std::vector<size_t> sizes;
+    size_t start = 0;
+    while (start < str.size()) {
+        size_t end = str.find(',', start);
+        if (end == std::string::npos) {
+            end = str.size();
+        }
+        sizes.push_back(std::stoull(str.substr(start, end - start)));
+        start = end + 1;
+    }
+    return sizes;
+}
+
+/**
+ * Checksum `total` bytes in buffers of `size` bytes and return the
+ * throughput in GB/s.
+ */
+static double measure(crc_function fn, const std::vector<uint8_t>& data,
+                      size_t size, uint64_t total, uint32_t& sink) {
+    uint64_t iterations = std::max<uint64_t>(1, total / size);
+    size_t buffers = data.size() / size;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        sink += fn(data.data() + (i % buffers) * size, size, 0);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return static_cast<double>(iterations * size) / elapsed.count() / 1e9;
+}
+
+int main(int argc, char** argv) {
+    gflags::SetUsageMessage(
+        "Measure CRC32C throughput of the hardware and portable "
+        "implementations\nUsage: crc32c-bench [flags]");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+    std::vector<size_t> sizes = parse_sizes(FLAGS_sizes);
+    size_t max_size = 0;
+    for (size_t size : sizes) {
+        if (size == 0) {
+            std::cerr << "ERROR: buffer sizes must be positive" << std::endl;
+            return 1;
+        }
+        max_size = std::max(max_size, size);
+    }
+
+    // Cycle through more data than fits in the caches of most CPUs for small
+    // buffers, like a log store reading through its entries would.
+    std::vector<uint8_t> data(std::max<size_t>(max_size, 64 * 1024 * 1024));
+    std::mt19937_64 rng(42);
+    for (auto& b : data) {
+        b = static_cast<uint8_t>(rng());
+    }
+
+    uint64_t total = FLAGS_totalmb * 1024 * 1024;
+    uint32_t sink = 0;
+
+    std::cout << "hardware acceleration: "
+              << (crc32c_is_hardware_accelerated() ? "SSE4.2" : "none")
+              << std::endl;
+    std::cout << std::setw(10) << "size" << std::setw(14) << "crc32c"
+              << std::setw(14) << "portable" << std::endl;
+    for (size_t size : sizes) {
+        double fast = measure(crc32c, data, size, total, sink);
+        double portable = measure(crc32c_portable, data, size, total, sink);
+        std::cout << std::setw(10) << size << std::fixed
+                  << std::setprecision(2) << std::setw(10) << fast << " GB/s"
+                  << std::setw(10) << portable << " GB/s" << std::endl;
+    }
+
+    // Printing the checksums keeps them from being optimized away.
+    std::cout << "combined checksum: " << std::hex << sink << std::endl;
+    return 0;
+}
@@ -17,6 +17,7 @@ DEFINE_string(e, "",
 #endif
 
 using replicated_splinterdb::client;
+using replicated_splinterdb::read_consistency;
 using replicated_splinterdb::rpc_mutation_result;
 
 static bool handle_mutation_result(rpc_mutation_result&& result);
@@ -27,10 +28,10 @@ static bool handle_command(rpc::client& c,
                            const std::vector<std::string>& tokens);
 
 bool handle_mutation_result(rpc_mutation_result&& result) {
-    auto [spl_rc, raft_rc, msg] = result;
+    auto [spl_rc, raft_rc, msg, log_idx] = result;
 
     if (raft_rc == 0 && spl_rc == 0) {
-        std::cout << "succeeded" << std::endl;
+        std::cout << "succeeded at log index " << log_idx << std::endl;
         return true;
     } else if (raft_rc != 0) {
         std::cout << "append log failed, rc=" << raft_rc << ": " << msg
@@ -79,9 +80,35 @@ static bool handle_command(client& c, const std::vector<std::string>& tokens) {
 
         auto res = c.del(key);
         return handle_mutation_result(std::move(res));
-    } else if (cmd == "get" && tokens.size() >= 2) {
+    } else if (cmd == "mput" && tokens.size() >= 3 && tokens.size() % 2 == 1) {
+        std::vector<std::vector<uint8_t>> keys, values;
+        for (size_t i = 1; i < tokens.size(); i += 2) {
+            keys.emplace_back(tokens[i].begin(), tokens[i].end());
+            values.emplace_back(tokens[i + 1].begin(), tokens[i + 1].end());
+        }
+
+        auto res = c.multi_put(keys, values);
+        return handle_mutation_result(std::move(res));
+    } else if (cmd == "mdelete" && tokens.size() >= 2) {
+        std::vector<std::vector<uint8_t>> keys;
+        for (size_t i = 1; i < tokens.size(); ++i) {
+            keys.emplace_back(tokens[i].begin(), tokens[i].end());
+        }
+
+        auto res = c.multi_del(keys);
+        return handle_mutation_result(std::move(res));
+    } else if ((cmd == "get" || cmd == "lget" || cmd == "leaseget") &&
+               tokens.size() >= 2) {
         std::vector<uint8_t> key(tokens[1].begin(), tokens[1].end());
-        auto [value, spl_rc] = c.get(key);
+
+        read_consistency consistency = read_consistency::STALE;
+        if (cmd == "lget") {
+            consistency = read_consistency::READ_INDEX;
+        } else if (cmd == "leaseget") {
+            consistency = read_consistency::LEASE;
+        }
+
+        auto [value, spl_rc] = c.get(key, consistency);
 
         if (spl_rc == 0) {
             std::cout << "value: " << std::string(value.begin(), value.end())
@@ -91,6 +118,48 @@ static bool handle_command(client& c, const std::vector<std::string>& tokens) {
             std::cout << "get failed, rc=" << spl_rc << std::endl;
             return false;
         }
+    } else if (cmd == "mget" && tokens.size() >= 2) {
+        std::vector<std::vector<uint8_t>> keys;
+        for (size_t i = 1; i < tokens.size(); ++i) {
+            keys.emplace_back(tokens[i].begin(), tokens[i].end());
+        }
+
+        auto results = c.multi_get(keys);
+        bool all_found = true;
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& [value, spl_rc] = results[i];
+            if (spl_rc == 0) {
+                std::cout << tokens[i + 1] << " : "
+                          << std::string(value.begin(), value.end())
+                          << std::endl;
+            } else {
+                std::cout << tokens[i + 1] << " : get failed, rc=" << spl_rc
+                          << std::endl;
+                all_found = false;
+            }
+        }
+
+        return all_found;
+    } else if (cmd == "scan") {
+        std::vector<uint8_t> start_key, end_key;
+        if (tokens.size() >= 2) {
+            start_key.assign(tokens[1].begin(), tokens[1].end());
+        }
+        if (tokens.size() >= 3) {
+            end_key.assign(tokens[2].begin(), tokens[2].end());
+        }
+
+        size_t count = 0;
+        for (auto it = c.scan(start_key, end_key); it.valid(); it.next()) {
+            std::cout << std::string(it.key().begin(), it.key().end())
+                      << " : "
+                      << std::string(it.value().begin(), it.value().end())
+                      << std::endl;
+            ++count;
+        }
+
+        std::cout << count << " keys" << std::endl;
+        return true;
     } else if (cmd == "ls") {
         std::vector<std::tuple<int32_t, std::string>> srvs =
             c.get_all_servers();
@@ -119,7 +188,15 @@ static bool handle_command(client& c, const std::vector<std::string>& tokens) {
         std::cout << "  put <key> <value>" << std::endl;
         std::cout << "  update <key> <value>" << std::endl;
         std::cout << "  delete <key>" << std::endl;
+        std::cout << "  mput <key1> <value1> [<key2> <value2> ...]"
+                  << std::endl;
+        std::cout << "  mdelete <key1> [<key2> ...]" << std::endl;
         std::cout << "  get <key>" << std::endl;
+        std::cout << "  lget <key> (linearizable)" << std::endl;
+        std::cout << "  leaseget <key> (linearizable, leader lease)"
+                  << std::endl;
+        std::cout << "  mget <key1> [<key2> ...]" << std::endl;
+        std::cout << "  scan [<start_key> [<end_key>]]" << std::endl;
         std::cout << "  ls" << std::endl;
         std::cout << "  dumpcache" << std::endl;
         std::cout << "  help" << std::endl;
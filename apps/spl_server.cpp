@@ -43,6 +43,66 @@ DEFINE_string(seed, "",
               "this server to the cluster. If empty, this server will start a "
               "new cluster.");
 DEFINE_int64(nthreads, 4, "The number of threads to use for RPC handling");
+DEFINE_int32(snapshotdistance, 0,
+             "The number of committed log entries between Raft snapshots; "
+             "snapshots and log compaction are disabled if not positive. "
+             "Every snapshot copies the data to a file next to the "
+             "SplinterDB file");
+DEFINE_uint64(snapshotchunksize, 1024,
+              "The maximum size (in KB) of a single snapshot object sent to "
+              "a follower");
+DEFINE_uint64(reservedlogentries, 10000,
+              "The number of log entries kept behind the last snapshot when "
+              "the log is compacted");
+DEFINE_uint64(groupcommitus, 0,
+              "The window (in microseconds) during which concurrent writes "
+              "are coalesced into a single Raft log entry; 0 disables group "
+              "commit");
+DEFINE_uint64(groupcommitmaxops, 256,
+              "The maximum number of writes coalesced into one group commit");
+DEFINE_uint64(readthreads, 4,
+              "The number of worker threads used to split large multi-key "
+              "reads; 0 reads on the RPC handler thread only");
+DEFINE_uint64(readleasems, 200,
+              "How long (in ms) the leader serves lease reads locally after "
+              "a majority last acknowledged it; must be below the election "
+              "timeout");
+DEFINE_uint64(parallelreadkeys, 64,
+              "The minimum number of keys in a multi-key read before it is "
+              "split across the read worker threads");
+
+DEFINE_string(logstore, "memory",
+              "Where to keep the Raft log: memory, splinterdb, shared (in "
+              "the data's SplinterDB instance) or file. The splinterdb and "
+              "shared log stores cannot sync their entries, and refuse to "
+              "start with any logdurability but none");
+DEFINE_string(logdir, "",
+              "The directory holding the segment files of a 'file' log "
+              "store; defaults to raft-log-<serverid>");
+DEFINE_uint64(logsegmentsize, 64,
+              "The size (in MB) of each preallocated log segment file");
+DEFINE_string(statedir, "",
+              "The directory holding the Raft cluster config and server state "
+              "when the log store is persistent; defaults to "
+              "raft-state-<serverid>");
+DEFINE_uint64(logcacheentries, 4096,
+              "The number of recent log entries a 'splinterdb' log store keeps "
+              "in memory");
+DEFINE_string(logdurability, "",
+              "When appended log entries are synced to disk: none, group "
+              "(batched, see logsyncus and logsynckb) or append (every "
+              "append waits for its sync). Defaults to group for a 'file' "
+              "log store and none otherwise; 'splinterdb' and 'shared' log "
+              "stores only support none");
+DEFINE_uint64(logsyncus, 1000,
+              "In group durability mode, the longest (in microseconds) an "
+              "appended log entry waits to be synced");
+DEFINE_uint64(logsynckb, 1024,
+              "In group durability mode, the amount (in KB) of unsynced log "
+              "data that triggers a sync right away");
+DEFINE_bool(parallelappend, true,
+            "Sync log entries in the background while the leader replicates "
+            "them (file log stores only)");
 
 DEFINE_validator(raftport, &validate_port);
 DEFINE_validator(clientport, &validate_port);
@@ -58,6 +118,8 @@ DEFINE_uint64(
     maxkeysize, 100,
     "The maximum size of a key (in bytes) that can be stored in SplinterDB");
 
+using replicated_splinterdb::log_durability;
+using replicated_splinterdb::log_store_type;
 using replicated_splinterdb::LogLevel;
 using replicated_splinterdb::replica_config;
 using replicated_splinterdb::server;
@@ -127,6 +189,60 @@ int main(int argc, char** argv) {
     cfg.addr_ = hostnamebuf;
     cfg.raft_port_ = raft_port;
     cfg.client_port_ = client_port;
+    cfg.snapshot_frequency_ = FLAGS_snapshotdistance;
+    cfg.snapshot_chunk_size_ = FLAGS_snapshotchunksize * 1024;
+    cfg.reserved_log_entries_ = FLAGS_reservedlogentries;
+    cfg.group_commit_window_us_ = FLAGS_groupcommitus;
+    cfg.group_commit_max_ops_ = FLAGS_groupcommitmaxops;
+    cfg.read_threads_ = FLAGS_readthreads;
+    cfg.parallel_read_threshold_ = FLAGS_parallelreadkeys;
+    cfg.read_lease_ms_ = FLAGS_readleasems;
+
+    if (FLAGS_logstore == "memory") {
+        cfg.log_store_type_ = log_store_type::IN_MEMORY;
+    } else if (FLAGS_logstore == "splinterdb") {
+        cfg.log_store_type_ = log_store_type::SPLINTERDB;
+    } else if (FLAGS_logstore == "shared") {
+        cfg.log_store_type_ = log_store_type::SHARED_SPLINTERDB;
+    } else if (FLAGS_logstore == "file") {
+        cfg.log_store_type_ = log_store_type::FILE;
+    } else {
+        std::cerr << "ERROR: unknown log store '" << FLAGS_logstore
+                  << "'. Expected memory, splinterdb, shared or file."
+                  << std::endl;
+        return 1;
+    }
+
+    if (!FLAGS_logdir.empty()) {
+        cfg.log_store_dir_ = FLAGS_logdir;
+    }
+    if (!FLAGS_statedir.empty()) {
+        cfg.state_dir_ = FLAGS_statedir;
+    }
+    cfg.log_segment_size_ = FLAGS_logsegmentsize * 1024 * 1024;
+    cfg.log_tail_cache_entries_ = FLAGS_logcacheentries;
+
+    std::string durability = FLAGS_logdurability;
+    if (durability.empty()) {
+        durability =
+            cfg.log_store_type_ == log_store_type::FILE ? "group" : "none";
+    }
+
+    if (durability == "none") {
+        cfg.log_durability_ = log_durability::NONE;
+    } else if (durability == "group") {
+        cfg.log_durability_ = log_durability::GROUP_COMMIT;
+    } else if (durability == "append") {
+        cfg.log_durability_ = log_durability::PER_APPEND;
+    } else {
+        std::cerr << "ERROR: unknown log durability '" << FLAGS_logdurability
+                  << "'. Expected none, group or append." << std::endl;
+        return 1;
+    }
+
+    cfg.log_sync_interval_us_ = FLAGS_logsyncus;
+    cfg.log_sync_bytes_ = FLAGS_logsynckb * 1024;
+    cfg.parallel_log_appending_ = FLAGS_parallelappend;
 
     cfg.log_level_ = LogLevel::TRACE;
     cfg.display_level_ = LogLevel::DISABLED;
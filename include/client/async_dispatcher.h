@@ -0,0 +1,110 @@
+#ifndef REPLICATED_SPLINTERDB_CLIENT_ASYNC_DISPATCHER_H
+#define REPLICATED_SPLINTERDB_CLIENT_ASYNC_DISPATCHER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "rpc/client.h"
+
+namespace replicated_splinterdb {
+
+/**
+ * Waits for the replies to asynchronous RPCs on a thread of its own, so that
+ * a caller can have many calls in flight without a thread blocked on each.
+ *
+ * rpclib's futures cannot be waited on together, so the thread checks every
+ * pending reply in turn and otherwise waits briefly on one of them. A reply
+ * is noticed at most `POLL_INTERVAL` after it arrives.
+ */
+class async_dispatcher {
+  public:
+    using reply = clmdep_msgpack::object_handle;
+
+    static constexpr std::chrono::microseconds POLL_INTERVAL{50};
+
+    /**
+     * A call, and what to do with its reply. Only `send_` of the first
+     * attempt runs on the submitting thread; everything else runs on the
+     * dispatcher's thread.
+     */
+    struct operation {
+        std::function<std::future<reply>()> send_;
+
+        // Returns std::nullopt once the operation is done, or the delay after
+        // which to send the call again, e.g. to retry on a new leader.
+        std::function<std::optional<std::chrono::milliseconds>(reply&)>
+            on_reply_;
+
+        // Called instead of `on_reply_` if the call failed or timed out, or
+        // if `on_reply_` or a resend threw.
+        std::function<void(std::exception_ptr)> on_error_;
+    };
+
+    /**
+     * Every attempt at a call fails if it has not been answered within
+     * `timeout`.
+     */
+    explicit async_dispatcher(std::chrono::milliseconds timeout);
+
+    /**
+     * Stop waiting for replies. Operations still pending are dropped without
+     * any of their functions being called.
+     */
+    ~async_dispatcher();
+
+    async_dispatcher(const async_dispatcher&) = delete;
+
+    async_dispatcher& operator=(const async_dispatcher&) = delete;
+
+    /**
+     * Send the call of `op` right away and wait for its reply in the
+     * background. Throws whatever sending throws.
+     */
+    void submit(operation op);
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    struct pending {
+        std::unique_ptr<operation> op_;
+
+        // Invalid while the operation waits to be sent again.
+        std::future<reply> reply_;
+
+        // When the reply is due or, while it waits, when to send again.
+        clock::time_point deadline_;
+    };
+
+    const std::chrono::milliseconds timeout_;
+
+    std::mutex lock_;
+    std::condition_variable submitted_cv_;
+
+    // Operations submitted since the thread last picked them up.
+    std::vector<pending> submitted_;
+
+    bool stopped_;
+
+    std::thread thread_;
+
+    void run();
+
+    /**
+     * Make progress on `p`.
+     *
+     * @return `true` once the operation is done.
+     */
+    bool poll(pending& p, clock::time_point now);
+};
+
+}  // namespace replicated_splinterdb
+
+#endif  // REPLICATED_SPLINTERDB_CLIENT_ASYNC_DISPATCHER_H
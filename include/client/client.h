@@ -1,14 +1,44 @@
 #ifndef REPLICATED_SPLINTERDB_CLIENT_CLIENT_H
 #define REPLICATED_SPLINTERDB_CLIENT_CLIENT_H
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
+#include "client/async_dispatcher.h"
+#include "client/latency_tracker.h"
 #include "client/read_policy.h"
+#include "client/scan_iterator.h"
+#include "client/value_cache.h"
 #include "common/types.h"
 #include "rpc/client.h"
 
 namespace replicated_splinterdb {
 
+class connection_slots;
+
+/**
+ * How many STALE reads were hedged, and how many of those were answered by
+ * the second server first.
+ */
+struct hedge_stats {
+    uint64_t issued_;
+    uint64_t won_;
+};
+
+/**
+ * A client of a replicated SplinterDB cluster. All of its calls are
+ * thread-safe, so one client can be shared by every thread of an
+ * application. Requests go over a pool of connections to every server, and
+ * each thread sticks to the connection of every pool used by the fewest
+ * live threads, so threads only share a connection once there are more of
+ * them than connections.
+ */
 class client {
   public:
     client() = delete;
@@ -17,10 +47,51 @@ class client {
 
     client& operator=(const client&) = delete;
 
+    /**
+     * Connect to the cluster that the server at `host`:`port` belongs to,
+     * opening `connections_per_server` connections to every server. Reads
+     * that may go to any server are spread according to `policy`.
+     */
     client(const std::string& host, uint16_t port, uint64_t timeout_ms = 10000,
-           uint16_t num_retries = 3);
+           uint16_t num_retries = 3,
+           read_policy_type policy = read_policy_type::LATENCY_AWARE,
+           uint16_t connections_per_server = 1);
+
+    ~client();
+
+    /**
+     * Look up a key. STALE reads go to any server picked by the read policy,
+     * but still observe every write this client has seen acknowledged.
+     * READ_INDEX and LEASE reads are served by the leader and observe every
+     * write committed before the call.
+     *
+     * With hedged reads enabled, a STALE read that has not been answered in
+     * time is sent to a second server as well; see `enable_hedged_reads`.
+     * With the value cache enabled, STALE reads of cached keys are answered
+     * from it; see `enable_value_cache`.
+     */
+    rpc_read_result get(
+        const std::vector<uint8_t>& key,
+        read_consistency consistency = read_consistency::STALE);
+
+    /**
+     * Look up several keys, returning one (value, return code) per key in the
+     * same order. The keys are split into contiguous groups, one per server
+     * picked by the read policy, and the groups are fetched concurrently.
+     */
+    std::vector<rpc_read_result> multi_get(
+        const std::vector<std::vector<uint8_t>>& keys);
 
-    rpc_read_result get(const std::vector<uint8_t>& key);
+    /**
+     * Scan the keys in [`start_key`, `end_key`) in key order. An empty
+     * `end_key` scans to the end of the store. Pairs are fetched from a
+     * single server, `page_entries` pairs (or about `page_bytes` bytes) at a
+     * time.
+     */
+    scan_iterator scan(const std::vector<uint8_t>& start_key,
+                       const std::vector<uint8_t>& end_key,
+                       uint32_t page_entries = 1000,
+                       uint64_t page_bytes = 1024 * 1024);
 
     rpc_mutation_result put(const std::vector<uint8_t>& key,
                             const std::vector<uint8_t>& value);
@@ -30,6 +101,87 @@ class client {
 
     rpc_mutation_result del(const std::vector<uint8_t>& key);
 
+    /**
+     * Put several key-value pairs in a single Raft log entry. Only the log
+     * entry is atomic: once it is committed, every pair is applied, but a
+     * concurrent reader may see some of the pairs before the others.
+     */
+    rpc_mutation_result multi_put(
+        const std::vector<std::vector<uint8_t>>& keys,
+        const std::vector<std::vector<uint8_t>>& values);
+
+    /**
+     * Delete several keys in a single Raft log entry.
+     */
+    rpc_mutation_result multi_del(
+        const std::vector<std::vector<uint8_t>>& keys);
+
+    /**
+     * Asynchronous versions of the calls above. They return as soon as the
+     * request has been sent, so that one client can keep many requests in
+     * flight. Replies, the fallback to the leader and retries on a leader
+     * change are handled on a background thread. STALE reads are served
+     * from the value cache when it is enabled, but are not hedged.
+     *
+     * A request that goes unanswered for the client's timeout fails with a
+     * `std::runtime_error`. One still pending when the client is destroyed
+     * fails with a broken promise.
+     */
+    std::future<rpc_read_result> get_async(
+        const std::vector<uint8_t>& key,
+        read_consistency consistency = read_consistency::STALE);
+
+    std::future<std::vector<rpc_read_result>> multi_get_async(
+        const std::vector<std::vector<uint8_t>>& keys);
+
+    std::future<rpc_mutation_result> put_async(
+        const std::vector<uint8_t>& key, const std::vector<uint8_t>& value);
+
+    std::future<rpc_mutation_result> update_async(
+        const std::vector<uint8_t>& key, const std::vector<uint8_t>& value);
+
+    std::future<rpc_mutation_result> del_async(
+        const std::vector<uint8_t>& key);
+
+    /**
+     * Hedge STALE reads: once the first server has taken longer than the
+     * `percentile` of recent read latencies, send the read to a second
+     * server too, and take whichever answer comes first. Hedging costs extra
+     * reads, about `1 - percentile` of them, so it is off by default.
+     */
+    void enable_hedged_reads(double percentile = 0.95);
+
+    void disable_hedged_reads();
+
+    hedge_stats get_hedge_stats() const;
+
+    /**
+     * Cache the values of keys read with `get` at STALE consistency, up to
+     * about `max_bytes` of them. A background thread asks the leader every
+     * `refresh_interval` for the keys changed since it last asked, and drops
+     * their cached values. Cached values are only served while the leader
+     * has answered within `lease`. They can lag behind the leader by about
+     * the refresh interval, and never by more than the lease. Keys written
+     * through this client are dropped once the write is acknowledged.
+     */
+    void enable_value_cache(
+        size_t max_bytes,
+        std::chrono::milliseconds refresh_interval =
+            std::chrono::milliseconds(10),
+        std::chrono::milliseconds lease = std::chrono::milliseconds(100));
+
+    void disable_value_cache();
+
+    /**
+     * Drop every cached value.
+     */
+    void reset_value_cache();
+
+    /**
+     * Counters of the value cache, all zero while it is disabled.
+     */
+    value_cache_stats get_value_cache_stats() const;
+
     void trigger_cache_dumps();
 
     void trigger_cache_clear();
@@ -39,14 +191,123 @@ class client {
     int32_t get_leader_id();
 
   private:
-    std::map<int32_t, rpc::client> clients_;
+    using connection_pool = std::vector<std::unique_ptr<rpc::client>>;
+
+    std::map<int32_t, connection_pool> clients_;
+
+    // Which connection of every pool each thread uses. Threads that use this
+    // client hold on to it, so that they can give their slot back on exit.
+    std::shared_ptr<connection_slots> slots_;
+
     std::unique_ptr<read_policy> read_policy_;
-    int32_t leader_id_;
+    std::atomic<int32_t> leader_id_;
+
+    // Set while `find_leader_async` is looking for the leader.
+    std::atomic<bool> finding_leader_;
+    const uint64_t timeout_ms_;
+
+    // Latencies of STALE reads, tracked while hedged reads are enabled.
+    // Swapped atomically, so that hedging can be toggled while reads run.
+    std::shared_ptr<latency_tracker> read_latency_;
+    std::atomic<uint64_t> hedges_issued_;
+    std::atomic<uint64_t> hedges_won_;
+
+    // Set while the value cache is enabled, and swapped atomically like
+    // `read_latency_`.
+    std::shared_ptr<value_cache> value_cache_;
+
+    // Keeps `value_cache_` up to date.
+    std::thread cache_refresher_;
+    bool stop_cache_refresher_;
+    std::condition_variable cache_refresher_cv_;
+
+    // Protects `cache_refresher_` and `stop_cache_refresher_`.
+    std::mutex cache_refresher_lock_;
+
+    // Serializes enabling and disabling the value cache.
+    std::mutex cache_control_lock_;
+
+    // Highest Raft log number of any write acknowledged to this client. Reads
+    // only go to replicas that have applied at least this much of the log.
+    std::atomic<raft_log_index> last_seen_idx_;
     const uint16_t num_retries_;
 
+    // Declared last so that its thread stops before anything the pending
+    // requests use goes away.
+    async_dispatcher dispatcher_;
+
+    /**
+     * The connection to `srv_id` used by the calling thread, picked the
+     * first time the thread calls.
+     */
+    rpc::client& handle(int32_t srv_id);
+
     rpc::client& get_leader_handle();
 
+    void note_log_index(raft_log_index idx);
+
+    rpc_read_result hedged_get(const std::vector<uint8_t>& key,
+                               raft_log_index min_idx,
+                               latency_tracker& latency);
+
+    /**
+     * Stop the refresher thread and drop the value cache. Caller must hold
+     * `cache_control_lock_`.
+     */
+    void stop_value_cache();
+
+    /**
+     * Ask the leader for the keys changed since `cache` was last refreshed.
+     */
+    void refresh_value_cache(value_cache& cache);
+
+    /**
+     * Drop written keys from the value cache, if it is enabled.
+     */
+    void forget_cached(const std::vector<std::vector<uint8_t>>& keys);
+
     bool try_handle_leader_change(int32_t raft_result_code);
+
+    /**
+     * Ask the servers for the leader in the background, on the dispatcher,
+     * and update `leader_id_` once one answers. Does nothing while a lookup
+     * is already under way, so it can be called from any failed request.
+     */
+    void find_leader_async();
+
+    /**
+     * Send the `attempt`-th request of a leader lookup.
+     */
+    void ask_for_leader_async(uint32_t attempt);
+
+    /**
+     * Send a write to the leader, and send it again to a new leader up to
+     * `num_retries_` times if it was not accepted because leadership changed.
+     * Any other failure, such as a timeout, is returned as is, since the
+     * write may have been applied anyway.
+     */
+    template <typename... Args>
+    rpc_mutation_result mutate(const std::string& rpc_name,
+                               const Args&... args);
+
+    /**
+     * Send a read to the replica `srv_id`, falling back to the leader if
+     * that replica has not caught up with `min_idx`.
+     */
+    template <typename Result, typename Arg>
+    void stale_read_async(int32_t srv_id, const std::string& rpc_name,
+                          const Arg& arg, raft_log_index min_idx,
+                          std::function<void(Result)> on_result,
+                          std::function<void(std::exception_ptr)> on_error);
+
+    /**
+     * Like `mutate`, without waiting for the result. The `written` keys are
+     * dropped from the value cache before the result is handed over.
+     */
+    template <typename... Args>
+    std::future<rpc_mutation_result> mutate_async(
+        std::vector<std::vector<uint8_t>> written, const std::string& rpc_name,
+        const Args&... args);
 };
 
 }  // namespace replicated_splinterdb
@@ -0,0 +1,46 @@
+#ifndef REPLICATED_SPLINTERDB_CLIENT_LATENCY_TRACKER_H
+#define REPLICATED_SPLINTERDB_CLIENT_LATENCY_TRACKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace replicated_splinterdb {
+
+/**
+ * Tracks a percentile of the last `window` latencies recorded. The
+ * percentile is recomputed every `refresh` samples, so reading it is cheap.
+ */
+class latency_tracker {
+  public:
+    latency_tracker(double percentile, size_t window = 1024,
+                    size_t refresh = 32);
+
+    void record(std::chrono::microseconds latency);
+
+    /**
+     * The tracked percentile, or zero until a full `refresh` worth of
+     * samples has been recorded.
+     */
+    std::chrono::microseconds value() const;
+
+  private:
+    const double percentile_;
+    const size_t refresh_;
+
+    // Ring of the most recent samples, in microseconds.
+    std::vector<int64_t> samples_;
+    size_t next_;
+    size_t count_;
+
+    std::atomic<int64_t> value_us_;
+
+    // Protects `samples_`, `next_` and `count_`.
+    std::mutex lock_;
+};
+
+}  // namespace replicated_splinterdb
+
+#endif  // REPLICATED_SPLINTERDB_CLIENT_LATENCY_TRACKER_H
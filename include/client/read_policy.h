@@ -1,38 +1,139 @@
 #ifndef REPLICATED_SPLINTERDB_READ_POLICY_H
 #define REPLICATED_SPLINTERDB_READ_POLICY_H
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
-#include <queue>
+#include <map>
+#include <vector>
 
 namespace replicated_splinterdb {
 
+enum class read_policy_type {
+    // Take turns between the servers.
+    ROUND_ROBIN,
+
+    // Prefer servers that have been answering quickly; see
+    // `latency_aware_read_policy`.
+    LATENCY_AWARE,
+};
+
+/**
+ * Picks the server for each read that may go to any server. Policies are
+ * shared by every thread using a client, so they must be thread-safe, and
+ * they are lock-free so that reads on different threads never wait on each
+ * other.
+ */
 class read_policy {
   public:
     virtual ~read_policy() = default;
 
     virtual int32_t next_server() = 0;
+
+    /**
+     * Called when a read is sent to `server_id`, which the policy picked.
+     */
+    virtual void on_read_start(int32_t server_id) {}
+
+    /**
+     * Called when a read sent to `server_id` completes after `latency`.
+     * `ok` is false if the server timed out or could not serve the read.
+     */
+    virtual void on_read_end(int32_t server_id,
+                             std::chrono::microseconds latency, bool ok) {}
+
+    /**
+     * Called instead of `on_read_end` when a read sent to `server_id` is
+     * given up on after `elapsed`, e.g. because a hedged read answered
+     * first. The read would have taken at least `elapsed`.
+     */
+    virtual void on_read_abandoned(int32_t server_id,
+                                   std::chrono::microseconds elapsed) {}
 };
 
 class round_robin_read_policy : public read_policy {
   public:
-    round_robin_read_policy(const std::vector<int32_t>& server_ids)
-        : server_ids_() {
-        for (auto id : server_ids) {
-            server_ids_.push(id);
-        }
-    }
-
-    int32_t next_server() override {
-        auto id = server_ids_.front();
-        server_ids_.pop();
-        server_ids_.push(id);
-        return id;
-    }
+    round_robin_read_policy(const std::vector<int32_t>& server_ids);
+
+    int32_t next_server() override;
+
+  private:
+    const std::vector<int32_t> server_ids_;
+    std::atomic<size_t> next_;
+};
+
+/**
+ * Picks two servers at random and sends the read to the one with the lower
+ * cost, the cost being its expected latency times one more than the number
+ * of its reads in flight.
+ *
+ * The expected latency is an exponentially weighted moving average that jumps
+ * straight up to any slower observation, and moves down at a rate set by
+ * `decay`. A failed read counts as taking at least `failure_penalty`. While a
+ * server gets no reads, its expected latency decays towards zero with the
+ * same time constant, so that a server that was slow or unreachable is tried
+ * again eventually.
+ */
+class latency_aware_read_policy : public read_policy {
+  public:
+    latency_aware_read_policy(
+        const std::vector<int32_t>& server_ids,
+        std::chrono::microseconds failure_penalty = std::chrono::seconds(1),
+        std::chrono::microseconds decay = std::chrono::seconds(5));
+
+    int32_t next_server() override;
+
+    void on_read_start(int32_t server_id) override;
+
+    void on_read_end(int32_t server_id, std::chrono::microseconds latency,
+                     bool ok) override;
+
+    /**
+     * Only raises the expected latency to `elapsed` if it is lower, since
+     * the read says nothing about how much longer it would have taken.
+     */
+    void on_read_abandoned(int32_t server_id,
+                           std::chrono::microseconds elapsed) override;
 
   private:
-    std::queue<int32_t> server_ids_;
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * Concurrent updates are not applied atomically as a whole. One that
+     * races with another may weigh its sample against a slightly stale
+     * estimate, which is fine for a heuristic.
+     */
+    struct server_stats {
+        // Expected latency in microseconds, as of `updated_us_`.
+        std::atomic<double> cost_us_{0};
+
+        // Microseconds since the epoch of `clock`.
+        std::atomic<int64_t> updated_us_{0};
+
+        std::atomic<uint32_t> outstanding_{0};
+    };
+
+    static int64_t clock_us();
+
+    /**
+     * How much of an expected latency last updated at `updated_us` is left
+     * at `now_us`, between 0 and 1.
+     */
+    double decay_weight(int64_t updated_us, int64_t now_us) const;
+
+    double load(const server_stats& stats, int64_t now_us) const;
+
+    static void end_outstanding(server_stats& stats);
+
+    const double failure_penalty_us_;
+    const double decay_us_;
+
+    const std::vector<int32_t> server_ids_;
+
+    // Only the values change after construction, so lookups need no lock.
+    std::map<int32_t, server_stats> stats_;
 };
 
 }  // namespace replicated_splinterdb
 
-#endif  // REPLICATED_SPLINTERDB_READ_POLICY_H
\ No newline at end of file
+#endif  // REPLICATED_SPLINTERDB_READ_POLICY_H
@@ -0,0 +1,69 @@
+#ifndef REPLICATED_SPLINTERDB_CLIENT_SCAN_ITERATOR_H
+#define REPLICATED_SPLINTERDB_CLIENT_SCAN_ITERATOR_H
+
+#include <future>
+
+#include "common/types.h"
+#include "rpc/client.h"
+
+namespace replicated_splinterdb {
+
+/**
+ * Lazily iterates over the key-value pairs of a range scan, one page at a
+ * time. While the caller consumes a page, the next one is already being
+ * fetched from the server.
+ *
+ * All pages are read from the same server, once it has applied the log up to
+ * a given index. The iterator must not outlive the client that created it.
+ */
+class scan_iterator {
+  public:
+    scan_iterator(const scan_iterator&) = delete;
+
+    scan_iterator& operator=(const scan_iterator&) = delete;
+
+    scan_iterator(scan_iterator&&) = default;
+
+    scan_iterator& operator=(scan_iterator&&) = default;
+
+    bool valid() const { return pos_ < page_.size(); }
+
+    void next();
+
+    const std::vector<uint8_t>& key() const { return std::get<0>(page_[pos_]); }
+
+    const std::vector<uint8_t>& value() const {
+        return std::get<1>(page_[pos_]);
+    }
+
+  private:
+    friend class client;
+
+    scan_iterator(rpc::client& cl, const std::vector<uint8_t>& start_key,
+                  const std::vector<uint8_t>& end_key, uint32_t page_entries,
+                  uint64_t page_bytes, raft_log_index min_log_idx);
+
+    // Request the page starting at `continuation` (or at the start key, if
+    // empty) without waiting for it.
+    void prefetch(const std::vector<uint8_t>& continuation);
+
+    // Wait for the prefetched page, make it current and prefetch the next.
+    void advance_page();
+
+    rpc::client* cl_;
+    std::vector<uint8_t> start_key_;
+    std::vector<uint8_t> end_key_;
+    uint32_t page_entries_;
+    uint64_t page_bytes_;
+    raft_log_index min_log_idx_;
+
+    std::vector<rpc_kv_pair> page_;
+    size_t pos_;
+
+    std::future<RPCLIB_MSGPACK::object_handle> next_page_;
+    bool has_next_page_;
+};
+
+}  // namespace replicated_splinterdb
+
+#endif  // REPLICATED_SPLINTERDB_CLIENT_SCAN_ITERATOR_H
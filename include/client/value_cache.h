@@ -0,0 +1,185 @@
+#ifndef REPLICATED_SPLINTERDB_CLIENT_VALUE_CACHE_H
+#define REPLICATED_SPLINTERDB_CLIENT_VALUE_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/types.h"
+
+namespace replicated_splinterdb {
+
+/**
+ * Counters of a `value_cache`. `entries_` and `bytes_` describe its current
+ * contents, the others count events since the cache was created.
+ */
+struct value_cache_stats {
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t inserts_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t invalidations_ = 0;
+    uint64_t resets_ = 0;
+
+    uint64_t entries_ = 0;
+    uint64_t bytes_ = 0;
+
+    double hit_rate() const {
+        uint64_t total = hits_ + misses_;
+        return total ? static_cast<double>(hits_) / static_cast<double>(total)
+                     : 0.0;
+    }
+};
+
+/**
+ * Values of recently read keys, bounded by their total size and evicted with
+ * the CLOCK algorithm: a hit only sets the entry's reference bit, so lookups
+ * on different threads share a lock instead of reordering a list.
+ *
+ * The cache follows the keys changed on the server, as reported by the
+ * server's change log, up to `through` (see `apply_changes`). Its values are
+ * only served while that has been refreshed within the `lease`, so a cache
+ * that cannot reach the server stops serving rather than going stale.
+ *
+ * A value read from the server is only inserted if nothing was invalidated
+ * since the read started. The read must have been served by a replica that
+ * applied the log up to `through` as of that start; see `fill_position`.
+ */
+class value_cache {
+  public:
+    // Approximate memory taken by an entry besides its key and value.
+    static constexpr size_t ENTRY_OVERHEAD = 64;
+
+    /**
+     * Where the cache stood when a read to fill it started.
+     */
+    struct fill_position {
+        uint64_t epoch_;
+        raft_log_index through_;
+    };
+
+    value_cache(size_t max_bytes, std::chrono::milliseconds lease);
+
+    value_cache(const value_cache&) = delete;
+
+    value_cache& operator=(const value_cache&) = delete;
+
+    /**
+     * @return `true` if `key` is cached and the lease is current, with its
+     *         value copied to `value`.
+     */
+    bool lookup(const std::vector<uint8_t>& key, std::vector<uint8_t>& value);
+
+    fill_position start_fill() const;
+
+    /**
+     * Cache the `value` of `key`, read after `start_fill` returned `pos`.
+     * Values larger than the whole cache are not cached.
+     */
+    void insert(const std::vector<uint8_t>& key,
+                const std::vector<uint8_t>& value, const fill_position& pos);
+
+    /**
+     * Drop the cached values of `keys`, e.g. after writing them.
+     */
+    void invalidate(const std::vector<std::vector<uint8_t>>& keys);
+
+    /**
+     * Drop the values of the `keys` changed on the server up to log index
+     * `through`, and renew the lease.
+     */
+    void apply_changes(const std::vector<std::vector<uint8_t>>& keys,
+                       raft_log_index through);
+
+    /**
+     * Drop every value, because any key may have changed up to `through`,
+     * and renew the lease.
+     */
+    void reset(raft_log_index through);
+
+    /**
+     * Drop every value.
+     */
+    void clear();
+
+    /**
+     * The log index up to which changes on the server have been applied.
+     */
+    raft_log_index through() const;
+
+    value_cache_stats get_stats() const;
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    struct entry {
+        // Points at the key in `index_`.
+        const std::string* key_ = nullptr;
+        std::vector<uint8_t> value_;
+        std::atomic<bool> referenced_{false};
+    };
+
+    const size_t max_bytes_;
+    const std::chrono::milliseconds lease_;
+
+    // Slots of the CLOCK; unused ones have no key and are in `free_`.
+    std::deque<entry> slots_;
+    std::vector<size_t> free_;
+    size_t hand_;
+
+    std::unordered_map<std::string, size_t> index_;
+    size_t bytes_;
+
+    // Bumped by every invalidation, to turn away fills that raced with it.
+    uint64_t epoch_;
+
+    raft_log_index through_;
+
+    // When the lease was last renewed, in microseconds since the epoch of
+    // `clock`.
+    std::atomic<int64_t> renewed_us_;
+
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    uint64_t inserts_;
+    uint64_t evictions_;
+    uint64_t invalidations_;
+    uint64_t resets_;
+
+    // Shared by lookups, exclusive for everything that changes the cache.
+    mutable std::shared_mutex lock_;
+
+    static int64_t clock_us();
+
+    void renew_lease();
+
+    /**
+     * Drop the value in `slot`. Caller must hold `lock_` exclusively.
+     */
+    void erase(size_t slot);
+
+    /**
+     * Drop the values of `keys`. Caller must hold `lock_` exclusively.
+     */
+    void erase_keys(const std::vector<std::vector<uint8_t>>& keys);
+
+    /**
+     * Drop every value. Caller must hold `lock_` exclusively.
+     */
+    void erase_all();
+
+    /**
+     * Evict values until `size` more bytes fit. Caller must hold `lock_`
+     * exclusively.
+     */
+    void make_room(size_t size);
+};
+
+}  // namespace replicated_splinterdb
+
+#endif  // REPLICATED_SPLINTERDB_CLIENT_VALUE_CACHE_H
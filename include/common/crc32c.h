@@ -0,0 +1,30 @@
+#ifndef REPLICATED_SPLINTERDB_COMMON_CRC32C_H
+#define REPLICATED_SPLINTERDB_COMMON_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace replicated_splinterdb {
+
+/**
+ * CRC32C (Castagnoli) of `size` bytes at `data`. Pass the result of a previous
+ * call as `crc` to extend a checksum over more data.
+ *
+ * Uses the SSE4.2 `crc32` instruction when the CPU has it, and a table-driven
+ * implementation otherwise.
+ */
+uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+/**
+ * The table-driven implementation, whatever the CPU supports.
+ */
+uint32_t crc32c_portable(const void* data, size_t size, uint32_t crc = 0);
+
+/**
+ * Whether `crc32c` runs on the SSE4.2 instruction.
+ */
+bool crc32c_is_hardware_accelerated();
+
+}  // namespace replicated_splinterdb
+
+#endif  // REPLICATED_SPLINTERDB_COMMON_CRC32C_H
@@ -11,9 +11,15 @@
 #define RPC_GET_ALL_SERVERS "get_all_servers"
 #define RPC_GET_SRV_ENDPOINT "get_srv_endpoint"
 #define RPC_SPLINTERDB_GET "splinterdb_get"
+#define RPC_SPLINTERDB_CONSISTENT_GET "splinterdb_consistent_get"
+#define RPC_SPLINTERDB_MULTI_GET "splinterdb_multi_get"
+#define RPC_SPLINTERDB_SCAN "splinterdb_scan"
+#define RPC_SPLINTERDB_GET_CHANGES "splinterdb_get_changes"
 #define RPC_SPLINTERDB_PUT "splinterdb_put"
 #define RPC_SPLINTERDB_UPDATE "splinterdb_update"
 #define RPC_SPLINTERDB_DELETE "splinterdb_delete"
+#define RPC_SPLINTERDB_MULTI_PUT "splinterdb_multi_put"
+#define RPC_SPLINTERDB_MULTI_DELETE "splinterdb_multi_delete"
 #define RPC_SPLINTERDB_DUMPCACHE "splinterdb_dumpcache"
 #define RPC_SPLINTERDB_CLEARCACHE "splinterdb_clearcache"
 
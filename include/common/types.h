@@ -10,15 +10,53 @@ namespace replicated_splinterdb {
 
 using splinterdb_return_code = int32_t;
 
+/**
+ * How up to date a read has to be.
+ */
+enum class read_consistency : uint8_t {
+    // Whatever the serving replica has applied so far.
+    STALE = 0,
+
+    // Linearizable: the leader confirms it still holds leadership with a
+    // round of heartbeats, then waits until the commit index it saw at the
+    // start of the read has been applied.
+    READ_INDEX = 1,
+
+    // Linearizable, assuming bounded clock drift: the leader skips the
+    // heartbeat round while a majority acknowledged it within the lease.
+    // Falls back to READ_INDEX once the lease has expired.
+    LEASE = 2,
+};
+
 using nuraft_return_code = int32_t;
 
 using nuraft_return_msg = std::string;
 
+// For consistent reads, a negative return code is a nuraft::cmd_result_code,
+// e.g. NOT_LEADER when the read was sent to a follower.
 using rpc_read_result =
     std::tuple<std::vector<uint8_t>, splinterdb_return_code>;
 
+using raft_log_index = uint64_t;
+
+// The log index is the Raft log number the mutation was applied at, or 0 if
+// it was not applied.
 using rpc_mutation_result =
-    std::tuple<splinterdb_return_code, nuraft_return_code, nuraft_return_msg>;
+    std::tuple<splinterdb_return_code, nuraft_return_code, nuraft_return_msg,
+               raft_log_index>;
+
+using rpc_kv_pair = std::tuple<std::vector<uint8_t>, std::vector<uint8_t>>;
+
+// (pairs, key to resume the scan from, return code). The resume key is empty
+// once the scanned range is exhausted.
+using rpc_scan_result = std::tuple<std::vector<rpc_kv_pair>,
+                                   std::vector<uint8_t>, splinterdb_return_code>;
+
+// (changed keys, log index they cover up to, whether they are complete). An
+// incomplete result carries no keys: every key may have changed up to that
+// log index.
+using rpc_changes_result =
+    std::tuple<std::vector<std::vector<uint8_t>>, raft_log_index, bool>;
 
 bool is_success(const rpc_mutation_result& result);
 
@@ -26,6 +64,8 @@ nuraft_return_code get_nuraft_return_code(const rpc_mutation_result& result);
 
 bool was_accepted(const rpc_mutation_result& result);
 
+raft_log_index get_log_index(const rpc_mutation_result& result);
+
 }  // namespace replicated_splinterdb
 
 #endif  // REPLICATED_SPLINTERDB_TYPES_H
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+namespace replicated_splinterdb {
+
+/**
+ * When appended Raft log entries are synced to disk.
+ */
+enum class log_durability {
+    // Never sync; `flush` returns right away.
+    NONE,
+
+    // Sync at most every `log_sync_interval_us_` microseconds, or as soon as
+    // `log_sync_bytes_` bytes are waiting; `flush` syncs everything.
+    GROUP_COMMIT,
+
+    // Every append returns only once it has been synced. Concurrent appends
+    // share a sync.
+    PER_APPEND,
+};
+
+}  // namespace replicated_splinterdb
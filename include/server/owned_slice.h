@@ -33,6 +33,12 @@ class owned_slice {
     static void deserialize(owned_slice& slice_out,
                             nuraft::buffer_serializer& bs);
 
+    /**
+     * Read a serialized slice in place. The returned slice points into the
+     * serializer's buffer and is only valid for as long as that buffer is.
+     */
+    static slice deserialize_view(nuraft::buffer_serializer& bs);
+
     void serialize(nuraft::buffer_serializer& bs) const;
 
     size_t serialized_size() const;
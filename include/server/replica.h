@@ -1,7 +1,12 @@
 #ifndef REPLICATED_SPLINTERDB_SERVER_REPLICA_H
 #define REPLICATED_SPLINTERDB_SERVER_REPLICA_H
 
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
 #include "common/timer.h"
+#include "common/types.h"
 #include "libnuraft/nuraft.hxx"
 #include "server/owned_slice.h"
 #include "server/replica_config.h"
@@ -11,6 +16,8 @@ namespace replicated_splinterdb {
 
 class splinterdb_state_machine;
 
+class read_pool;
+
 class replica {
   public:
     using raft_result = nuraft::cmd_result<nuraft::ptr<nuraft::buffer>>;
@@ -28,18 +35,92 @@ class replica {
 
     explicit replica(const replica_config& config);
 
+    /**
+     * Dump the SplinterDB cache to a file, and log the hit rates of the log
+     * store's caches if it has any.
+     */
     void dump_cache();
 
     void clear_cache();
 
-    std::pair<owned_slice, int32_t> read(slice&& key);
+    /**
+     * Look up `key` using a lookup buffer owned by the calling thread, so that
+     * small values are read without any allocation. On success, `value`
+     * points into that buffer and stays valid until the thread's next `read`.
+     */
+    int32_t read(slice key, slice& value);
+
+    /**
+     * Wait until a read served by this replica is guaranteed to observe every
+     * write committed before the call, without appending to the Raft log.
+     *
+     * @return 0 once the read can be served, or a (negative)
+     *         `nuraft::cmd_result_code`: NOT_LEADER if this replica is not
+     *         the leader, TIMEOUT if leadership could not be confirmed, no
+     *         entry of the current term has committed yet, or the read index
+     *         was not applied in time.
+     */
+    int32_t prepare_consistent_read(read_consistency consistency);
+
+    /**
+     * Wait briefly until this replica has applied the Raft log
+     * `min_log_idx`, so that a read observes a write the client has already
+     * seen acknowledged.
+     *
+     * @return 0 once the log has been applied, or `nuraft::cmd_result_code`
+     *         TIMEOUT if this replica is still behind.
+     */
+    int32_t wait_for_applied(raft_log_index min_log_idx);
+
+    /**
+     * Collect the keys changed by the log entries this replica applied after
+     * `since_idx`, for clients that cache values. At most about `max_keys`
+     * keys are collected, and `through_idx` is set to the last entry they
+     * cover.
+     *
+     * @return `false` if the changes are no longer known, in which case every
+     *         key has to be taken as changed up to `through_idx`.
+     */
+    bool changed_keys(raft_log_index since_idx, size_t max_keys,
+                      std::vector<std::vector<uint8_t>>& keys,
+                      raft_log_index& through_idx) const;
+
+    /**
+     * Look up several keys, returning one (value, return code) per key in the
+     * same order. Large batches are spread over the read worker threads.
+     */
+    std::vector<rpc_read_result> multi_read(
+        const std::vector<std::vector<uint8_t>>& keys);
+
+    /**
+     * Read the key-value pairs in [`start_key`, `end_key`) in key order, up
+     * to `max_entries` pairs or until their total size reaches `max_bytes`
+     * (at least one pair is always returned). An empty `end_key` scans to the
+     * end of the store.
+     *
+     * On success, `next_key` is set to the first key that was not returned,
+     * or cleared if the range is exhausted.
+     */
+    int32_t scan(slice start_key, slice end_key, size_t max_entries,
+                 size_t max_bytes, std::vector<rpc_kv_pair>& entries,
+                 std::vector<uint8_t>& next_key);
 
     std::pair<nuraft::cmd_result_code, std::string> add_server(
         int32_t server_id, const std::string& raft_endpoint,
         const std::string& client_endpoint);
 
+    /**
+     * Replicate an operation and wait until it has been committed (or
+     * rejected), regardless of the configured return method.
+     */
     nuraft::ptr<raft_result> append_log(const splinterdb_operation& operation);
 
+    /**
+     * Replicate an operation without waiting for it. `handle_result` is
+     * invoked once the operation has been committed or rejected; with the
+     * `async_handler` return method this happens on a Raft thread, so it
+     * should not block. `operation` must stay alive until then.
+     */
     void append_log(const splinterdb_operation& operation,
                     handle_commit_result handle_result);
 
@@ -83,8 +164,84 @@ class replica {
     nuraft::raft_launcher launcher_;
     nuraft::ptr<nuraft::raft_server> raft_instance_;
 
+    // Declared after `sm_` so that the workers are stopped before SplinterDB
+    // is closed.
+    std::unique_ptr<read_pool> read_pool_;
+
+    /**
+     * A write waiting to be replicated as part of a group commit.
+     */
+    struct pending_write {
+        const splinterdb_operation* op_;
+        nuraft::ptr<Timer> timer_;
+        handle_commit_result handle_result_;
+    };
+
+    // Writes waiting to join the next group commit.
+    std::vector<pending_write> group_queue_;
+
+    // Mutex for `group_queue_`.
+    std::mutex group_lock_;
+
+    // Signalled when the queued group reaches `group_commit_max_ops_`.
+    std::condition_variable group_full_cv_;
+
+    /**
+     * What this leader knows about a peer's acknowledgements, from NuRaft's
+     * callbacks. NuRaft has at most one append request in flight per peer,
+     * so an acknowledgement answers a request sent after the first one that
+     * was still unanswered; times are in microseconds of a steady clock.
+     */
+    struct peer_contact {
+        // When the first request since the last acknowledgement was about
+        // to be sent, or 0 if every request has been answered.
+        uint64_t unacked_since_us_ = 0;
+
+        // When the last acknowledged request was sent, at the earliest.
+        uint64_t acked_sent_us_ = 0;
+    };
+
+    // Contacts with the peers during the current leadership.
+    std::map<int32_t, peer_contact> peer_contacts_;
+
+    // Mutex for `peer_contacts_`.
+    std::mutex contact_lock_;
+
     void default_raft_params_init(nuraft::raft_params& params);
 
+    /**
+     * Create the Raft log store selected by `config_.log_store_type_`.
+     */
+    nuraft::ptr<nuraft::log_store> make_log_store() const;
+
+    /**
+     * Whether the log store syncs appended entries in the background, which
+     * is when NuRaft's parallel log appending is turned on. Only a file log
+     * store with a durability mode does.
+     */
+    bool syncs_log_in_background() const;
+
+    /**
+     * Keep track of the append requests this leader sends and the
+     * acknowledgements it gets back.
+     */
+    nuraft::cb_func::ReturnCode on_raft_event(nuraft::cb_func::Type type,
+                                              nuraft::cb_func::Param* param);
+
+    /**
+     * The latest time (in microseconds of a steady clock) such that a
+     * majority of the cluster, this leader included, acknowledged requests
+     * sent at or after it. Such an acknowledgement proves that this replica
+     * was still the leader when the request was sent.
+     */
+    uint64_t quorum_contact_us();
+
+    /**
+     * Replicate a group of writes as a single BATCH log entry, and give
+     * every write its own result.
+     */
+    void commit_group(std::vector<pending_write>&& group);
+
     void initialize();
 
     std::pair<nuraft::cmd_result_code, std::string> add_server(
@@ -4,11 +4,30 @@
 #include <optional>
 
 #include "libnuraft/nuraft.hxx"
+#include "server/log_durability.h"
 #include "server/log_level.h"
 #include "server/splinterdb_wrapper.h"
 
 namespace replicated_splinterdb {
 
+/**
+ * Where a replica keeps its Raft log.
+ */
+enum class log_store_type {
+    // In memory only; the log is lost on restart.
+    IN_MEMORY,
+
+    // In a dedicated SplinterDB instance.
+    SPLINTERDB,
+
+    // In the state machine's SplinterDB instance, under a reserved key
+    // prefix. Log and data share one cache and one set of threads.
+    SHARED_SPLINTERDB,
+
+    // In append-only segment files.
+    FILE,
+};
+
 struct replica_config {
     replica_config(const data_config& splinterdb_data_cfg,
                    const splinterdb_config& splinterdb_cfg)
@@ -18,8 +37,26 @@ struct replica_config {
           addr_("localhost"),
           asio_thread_pool_size_(10),
           snapshot_frequency_(0),
+          snapshot_chunk_size_(1024 * 1024),
+          reserved_log_entries_(10000),
           initialization_delay_ms_(250),
           initialization_retries_(20),
+          log_store_type_(log_store_type::IN_MEMORY),
+          log_store_dir_(std::nullopt),
+          log_segment_size_(64 * 1024 * 1024),
+          log_tail_cache_entries_(4096),
+          state_dir_(std::nullopt),
+          log_durability_(log_durability::GROUP_COMMIT),
+          log_sync_interval_us_(1000),
+          log_sync_bytes_(1024 * 1024),
+          parallel_log_appending_(true),
+          group_commit_window_us_(0),
+          group_commit_max_ops_(256),
+          read_threads_(4),
+          parallel_read_threshold_(64),
+          read_lease_ms_(200),
+          read_index_timeout_ms_(1000),
+          min_index_read_wait_ms_(50),
           raft_log_file_(std::nullopt),
           log_level_(LogLevel::INFO),
           display_level_(LogLevel::WARNING),
@@ -48,9 +85,72 @@ struct replica_config {
     // Raft-specific parameters
 
     int32_t snapshot_frequency_;
+    size_t snapshot_chunk_size_;
+    // Log entries kept behind the last snapshot when the log is compacted,
+    // so that a follower lagging by fewer entries catches up from the log
+    // instead of receiving a snapshot.
+    size_t reserved_log_entries_;
     size_t initialization_delay_ms_;
     size_t initialization_retries_;
 
+    // Raft log storage. `log_store_dir_` defaults to a directory named after
+    // the server ID; it holds the segment files of a FILE log store.
+    log_store_type log_store_type_;
+    std::optional<std::string> log_store_dir_;
+    uint64_t log_segment_size_;
+
+    // Number of recent entries a SplinterDB log store (shared or not) keeps
+    // in memory, so that replicating them does not read from SplinterDB.
+    size_t log_tail_cache_entries_;
+
+    // With any log store but IN_MEMORY, the Raft cluster config and server
+    // state are kept in `state_dir_` (by default a directory named after the
+    // server ID), and the SplinterDB data file is reopened on restart.
+    std::optional<std::string> state_dir_;
+
+    // When appended log entries reach the disk of a persistent log store. In
+    // GROUP_COMMIT mode, pending appends are synced after at most
+    // `log_sync_interval_us_` microseconds, or once `log_sync_bytes_` bytes
+    // are pending, whichever comes first. SplinterDB log stores (shared or
+    // not) cannot sync their entries and only accept NONE.
+    log_durability log_durability_;
+    uint64_t log_sync_interval_us_;
+    uint64_t log_sync_bytes_;
+
+    // Sync appended log entries in the background and let the leader
+    // replicate them meanwhile, instead of syncing before replicating. Only
+    // applies to FILE log stores with a durability mode.
+    bool parallel_log_appending_;
+
+    // Group commit parameters
+
+    // Concurrent single-key writes arriving within this window (in
+    // microseconds), up to `group_commit_max_ops_` of them, are replicated as
+    // one log entry. A window of 0 disables group commit.
+    size_t group_commit_window_us_;
+    size_t group_commit_max_ops_;
+
+    // Read parameters
+
+    // Multi-key reads of at least `parallel_read_threshold_` keys are split
+    // across `read_threads_` worker threads (plus the calling thread). Smaller
+    // reads, or any read when `read_threads_` is 0, run on the caller.
+    size_t read_threads_;
+    size_t parallel_read_threshold_;
+
+    // A leader serves LEASE reads locally for this long after a majority last
+    // acknowledged it. It must be shorter than the minimum election timeout.
+    size_t read_lease_ms_;
+
+    // How long a consistent read may wait to confirm leadership and to apply
+    // the read index before giving up.
+    size_t read_index_timeout_ms_;
+
+    // How long a read carrying a minimum log index is parked on a replica
+    // that has not applied that index yet, before the client is told to
+    // retry elsewhere.
+    size_t min_index_read_wait_ms_;
+
     // Logging information
 
     std::optional<std::string> raft_log_file_;
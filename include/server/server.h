@@ -1,6 +1,7 @@
 #ifndef REPLICATED_SPLINTERDB_SERVER_SERVER_H
 #define REPLICATED_SPLINTERDB_SERVER_SERVER_H
 
+#include "common/types.h"
 #include "rpc/server.h"
 #include "rpc/this_handler.h"
 #include "server/replica.h"
@@ -30,6 +31,8 @@ class server {
     rpc::server join_srv_;
 
     void initialize();
+
+    rpc_mutation_result replicate(const splinterdb_operation& op);
 };
 
 }  // namespace replicated_splinterdb
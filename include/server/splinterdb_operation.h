@@ -9,7 +9,7 @@ namespace replicated_splinterdb {
 
 class splinterdb_operation {
   public:
-    enum splinterdb_operation_type : uint8_t { PUT, UPDATE, DELETE };
+    enum splinterdb_operation_type : uint8_t { PUT, UPDATE, DELETE, BATCH };
 
     nuraft::ptr<nuraft::buffer> serialize() const;
 
@@ -19,6 +19,10 @@ class splinterdb_operation {
 
     splinterdb_operation_type type() const { return type_; }
 
+    const std::vector<splinterdb_operation>& sub_operations() const {
+        return sub_operations_;
+    }
+
     static splinterdb_operation deserialize(nuraft::buffer& payload_in);
 
     static splinterdb_operation make_put(owned_slice&& key,
@@ -29,15 +33,80 @@ class splinterdb_operation {
 
     static splinterdb_operation make_delete(owned_slice&& key);
 
+    /**
+     * Make a single operation out of several PUT, UPDATE or DELETE
+     * operations, so that they are replicated in one Raft log entry.
+     * Batches cannot be nested.
+     */
+    static splinterdb_operation make_batch(
+        std::vector<splinterdb_operation>&& operations);
+
+    /**
+     * Serialize several operations as a single BATCH operation, without
+     * taking ownership of them.
+     */
+    static nuraft::ptr<nuraft::buffer> serialize_batch(
+        const std::vector<const splinterdb_operation*>& operations);
+
   private:
     splinterdb_operation(owned_slice&& key, std::optional<owned_slice>&& value,
                          splinterdb_operation_type type);
 
+    explicit splinterdb_operation(
+        std::vector<splinterdb_operation>&& sub_operations);
+
     splinterdb_operation() = delete;
 
+    size_t serialized_size() const;
+
+    void serialize(nuraft::buffer_serializer& bs) const;
+
+    static splinterdb_operation deserialize(nuraft::buffer_serializer& bs);
+
     owned_slice key_;
     std::optional<owned_slice> value_;
+    std::vector<splinterdb_operation> sub_operations_;
+    splinterdb_operation_type type_;
+};
+
+/**
+ * Non-owning view of a serialized splinterdb_operation. The header is
+ * decoded in place and the key and value slices point directly into the
+ * buffer the view was decoded from, so that buffer must outlive the view.
+ *
+ * A BATCH view only carries the number of sub-operations; they follow it in
+ * the buffer and are decoded one by one with `deserialize(bs)` using the
+ * same serializer.
+ */
+class splinterdb_operation_view {
+  public:
+    using splinterdb_operation_type =
+        splinterdb_operation::splinterdb_operation_type;
+
+    static splinterdb_operation_view deserialize(nuraft::buffer& payload_in);
+
+    static splinterdb_operation_view deserialize(
+        nuraft::buffer_serializer& bs);
+
+    const slice& key() const { return key_; }
+
+    const slice& value() const { return value_; }
+
+    splinterdb_operation_type type() const { return type_; }
+
+    uint32_t batch_size() const { return batch_size_; }
+
+  private:
+    splinterdb_operation_view(slice key, slice value,
+                              splinterdb_operation_type type,
+                              uint32_t batch_size);
+
+    splinterdb_operation_view() = delete;
+
+    slice key_;
+    slice value_;
     splinterdb_operation_type type_;
+    uint32_t batch_size_;
 };
 
 }  // namespace replicated_splinterdb
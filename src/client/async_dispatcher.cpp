@@ -0,0 +1,120 @@
+#include "client/async_dispatcher.h"
+
+#include <stdexcept>
+
+namespace replicated_splinterdb {
+
+async_dispatcher::async_dispatcher(std::chrono::milliseconds timeout)
+    : timeout_(timeout), stopped_(false) {
+    thread_ = std::thread([this]() { run(); });
+}
+
+async_dispatcher::~async_dispatcher() {
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+        stopped_ = true;
+    }
+    submitted_cv_.notify_one();
+    thread_.join();
+}
+
+void async_dispatcher::submit(operation op) {
+    pending p{std::make_unique<operation>(std::move(op)), {}, {}};
+    p.reply_ = p.op_->send_();
+    p.deadline_ = clock::now() + timeout_;
+
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+        submitted_.push_back(std::move(p));
+    }
+    submitted_cv_.notify_one();
+}
+
+void async_dispatcher::run() {
+    std::vector<pending> in_flight;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(lock_);
+            if (in_flight.empty()) {
+                submitted_cv_.wait(
+                    lk, [this]() { return stopped_ || !submitted_.empty(); });
+            }
+
+            if (stopped_) {
+                return;
+            }
+
+            std::move(submitted_.begin(), submitted_.end(),
+                      std::back_inserter(in_flight));
+            submitted_.clear();
+        }
+
+        // Keep the operations still pending at the front, in order, and
+        // drop the rest in one go.
+        size_t before = in_flight.size();
+        size_t kept = 0;
+        clock::time_point now = clock::now();
+        for (size_t i = 0; i < before; ++i) {
+            if (poll(in_flight[i], now)) {
+                continue;
+            }
+
+            if (kept != i) {
+                in_flight[kept] = std::move(in_flight[i]);
+            }
+            kept++;
+        }
+        in_flight.erase(in_flight.begin() + kept, in_flight.end());
+
+        if (in_flight.empty() || kept < before) {
+            continue;
+        }
+
+        // Nothing has come in; wait a little for the oldest reply.
+        const pending& oldest = in_flight.front();
+        if (oldest.reply_.valid()) {
+            oldest.reply_.wait_for(POLL_INTERVAL);
+        } else {
+            std::this_thread::sleep_for(POLL_INTERVAL);
+        }
+    }
+}
+
+bool async_dispatcher::poll(pending& p, clock::time_point now) {
+    operation& op = *p.op_;
+    try {
+        if (!p.reply_.valid()) {
+            if (now < p.deadline_) {
+                return false;
+            }
+
+            p.reply_ = op.send_();
+            p.deadline_ = now + timeout_;
+            return false;
+        }
+
+        if (p.reply_.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready) {
+            if (now < p.deadline_) {
+                return false;
+            }
+
+            throw std::runtime_error("call timed out");
+        }
+
+        reply r = p.reply_.get();
+        std::optional<std::chrono::milliseconds> retry_delay =
+            op.on_reply_(r);
+        if (!retry_delay) {
+            return true;
+        }
+
+        p.deadline_ = now + *retry_delay;
+        return false;
+    } catch (...) {
+        op.on_error_(std::current_exception());
+        return true;
+    }
+}
+
+}  // namespace replicated_splinterdb
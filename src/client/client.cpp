@@ -1,23 +1,179 @@
 #include "client/client.h"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <optional>
 #include <thread>
 
 #include "common/rpc.h"
 
-// TODOS: Implement latency-based read policy
-
 #define GET_LEADER_NO_LIVE_LEADER (-1)
+#define CMD_RESULT_TIMEOUT (-2)
 #define CMD_RESULT_NOT_LEADER (-3)
 #define CMD_RESULT_REQUEST_CANCELLED (-1)
 #define CMD_RESULT_WEIRD_CASE (999)
 
+// How often a hedged read checks whether either server has answered.
+static constexpr std::chrono::microseconds HEDGE_POLL_INTERVAL(50);
+
+// How many times the read policy is asked for a server other than the first
+// one before a read goes unhedged.
+static constexpr int HEDGE_PICK_ATTEMPTS = 4;
+
+// How long a request waits before it is retried on a new leader.
+static constexpr std::chrono::milliseconds LEADER_CHANGE_BACKOFF(100);
+
+// Most changed keys asked for in one refresh of the value cache.
+static constexpr uint32_t CACHE_CHANGES_PER_CALL = 4096;
+
 namespace replicated_splinterdb {
 
+/**
+ * The threads using each connection of a client's pools. A thread takes the
+ * connection with the fewest users and releases it when it exits.
+ */
+class connection_slots {
+  public:
+    explicit connection_slots(size_t count) : lock_(), users_(count, 0) {}
+
+    size_t acquire() {
+        std::lock_guard<std::mutex> lk(lock_);
+        auto it = std::min_element(users_.begin(), users_.end());
+        (*it)++;
+        return static_cast<size_t>(it - users_.begin());
+    }
+
+    void release(size_t slot) {
+        std::lock_guard<std::mutex> lk(lock_);
+        users_[slot]--;
+    }
+
+  private:
+    std::mutex lock_;
+    std::vector<size_t> users_;
+};
+
+/**
+ * The slots the calling thread holds, by client. A client that is gone is
+ * left out when the slots are released.
+ */
+class thread_slots {
+  public:
+    ~thread_slots() {
+        for (auto& [slots, slot] : held_) {
+            if (auto s = slots.lock()) {
+                s->release(slot);
+            }
+        }
+    }
+
+    size_t get(const std::shared_ptr<connection_slots>& slots) {
+        auto it = held_.find(slots);
+        if (it != held_.end()) {
+            return it->second;
+        }
+
+        // Forget the clients that are gone before adding another.
+        for (auto i = held_.begin(); i != held_.end();) {
+            i = i->first.expired() ? held_.erase(i) : std::next(i);
+        }
+
+        size_t slot = slots->acquire();
+        held_.emplace(slots, slot);
+        return slot;
+    }
+
+  private:
+    std::map<std::weak_ptr<connection_slots>, size_t,
+             std::owner_less<std::weak_ptr<connection_slots>>>
+        held_;
+};
+
+/**
+ * Reports a read to the read policy: its start right away, and its outcome
+ * and latency once `done` is called. A read that is never done, e.g. because
+ * the call threw on a timeout, counts as failed.
+ */
+class read_feedback {
+  public:
+    read_feedback(read_policy& policy, int32_t server_id)
+        : policy_(&policy),
+          server_id_(server_id),
+          start_(std::chrono::steady_clock::now()) {
+        policy_->on_read_start(server_id_);
+    }
+
+    read_feedback(read_feedback&& other) noexcept
+        : policy_(other.policy_),
+          server_id_(other.server_id_),
+          start_(other.start_) {
+        other.policy_ = nullptr;
+    }
+
+    read_feedback(const read_feedback&) = delete;
+
+    read_feedback& operator=(const read_feedback&) = delete;
+
+    ~read_feedback() { done(false); }
+
+    /**
+     * @return The latency of the read.
+     */
+    std::chrono::microseconds done(bool ok) {
+        auto latency = elapsed();
+        if (policy_ != nullptr) {
+            policy_->on_read_end(server_id_, latency, ok);
+            policy_ = nullptr;
+        }
+        return latency;
+    }
+
+    /**
+     * Report that the read is no longer waited for.
+     */
+    void abandon() {
+        if (policy_ != nullptr) {
+            policy_->on_read_abandoned(server_id_, elapsed());
+            policy_ = nullptr;
+        }
+    }
+
+  private:
+    read_policy* policy_;
+    int32_t server_id_;
+    std::chrono::steady_clock::time_point start_;
+
+    std::chrono::microseconds elapsed() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_);
+    }
+};
+
 client::client(const std::string& host, uint16_t port, uint64_t timeout_ms,
-               uint16_t num_retries)
-    : clients_(), read_policy_(nullptr), num_retries_(num_retries) {
+               uint16_t num_retries, read_policy_type policy,
+               uint16_t connections_per_server)
+    : clients_(),
+      slots_(std::make_shared<connection_slots>(connections_per_server)),
+      read_policy_(nullptr),
+      finding_leader_(false),
+      timeout_ms_(timeout_ms),
+      read_latency_(nullptr),
+      hedges_issued_(0),
+      hedges_won_(0),
+      value_cache_(nullptr),
+      cache_refresher_(),
+      stop_cache_refresher_(false),
+      cache_refresher_cv_(),
+      cache_refresher_lock_(),
+      cache_control_lock_(),
+      last_seen_idx_(0),
+      num_retries_(num_retries),
+      dispatcher_(std::chrono::milliseconds(timeout_ms)) {
+    if (connections_per_server == 0) {
+        throw std::invalid_argument("need at least one connection per server");
+    }
+
     rpc::client cl{host, port};
 
     std::vector<std::tuple<int32_t, std::string>> srvs;
@@ -48,9 +204,12 @@ client::client(const std::string& host, uint16_t port, uint64_t timeout_ms,
 
         auto checked_port = static_cast<uint16_t>(srv_port);
         try {
-            clients_.emplace(std::piecewise_construct,
-                             std::forward_as_tuple(srv_id),
-                             std::forward_as_tuple(srv_host, checked_port));
+            connection_pool pool;
+            for (uint16_t i = 0; i < connections_per_server; ++i) {
+                pool.push_back(
+                    std::make_unique<rpc::client>(srv_host, checked_port));
+            }
+            clients_.emplace(srv_id, std::move(pool));
         } catch (const std::exception& e) {
             std::cerr << "WARNING: failed to connect to " << endpoint
                       << " ... skipping. Reason:\n\t" << e.what() << std::endl;
@@ -59,17 +218,28 @@ client::client(const std::string& host, uint16_t port, uint64_t timeout_ms,
     }
 
     std::vector<int32_t> srv_ids;
-    for (auto& [srv_id, c] : clients_) {
-        c.set_timeout(static_cast<int64_t>(timeout_ms));
+    for (auto& [srv_id, pool] : clients_) {
+        for (auto& c : pool) {
+            c->set_timeout(static_cast<int64_t>(timeout_ms));
+        }
         srv_ids.push_back(srv_id);
     }
 
-    read_policy_ = std::make_unique<round_robin_read_policy>(srv_ids);
+    if (policy == read_policy_type::LATENCY_AWARE) {
+        // A server that times out counts as taking at least the timeout, so
+        // it is avoided until that has decayed.
+        read_policy_ = std::make_unique<latency_aware_read_policy>(
+            srv_ids, std::chrono::milliseconds(timeout_ms));
+    } else {
+        read_policy_ = std::make_unique<round_robin_read_policy>(srv_ids);
+    }
 }
 
+client::~client() { disable_value_cache(); }
+
 void client::trigger_cache_dumps() {
-    for (auto& [id, c] : clients_) {
-        bool result = c.call(RPC_SPLINTERDB_DUMPCACHE).as<bool>();
+    for (auto& [id, pool] : clients_) {
+        bool result = handle(id).call(RPC_SPLINTERDB_DUMPCACHE).as<bool>();
 
         if (!result) {
             std::cerr << "WARNING: failed to dump cache on server " << id
@@ -79,8 +249,8 @@ void client::trigger_cache_dumps() {
 }
 
 void client::trigger_cache_clear() {
-    for (auto& [id, c] : clients_) {
-        bool result = c.call(RPC_SPLINTERDB_CLEARCACHE).as<bool>();
+    for (auto& [id, pool] : clients_) {
+        bool result = handle(id).call(RPC_SPLINTERDB_CLEARCACHE).as<bool>();
         std::cout << "moved past RPC call!" << std::endl;
 
         if (!result) {
@@ -90,106 +260,697 @@ void client::trigger_cache_clear() {
     }
 }
 
-rpc::client& client::get_leader_handle() { return clients_.at(leader_id_); }
+rpc::client& client::handle(int32_t srv_id) {
+    thread_local thread_slots held;
+
+    connection_pool& pool = clients_.at(srv_id);
+    return *pool[held.get(slots_) % pool.size()];
+}
+
+rpc::client& client::get_leader_handle() { return handle(leader_id_); }
+
+static bool is_leader_change(int32_t raft_rc) {
+    return raft_rc == CMD_RESULT_NOT_LEADER ||
+           raft_rc == CMD_RESULT_REQUEST_CANCELLED;
+}
 
 bool client::try_handle_leader_change(int32_t raft_rc) {
-    if (raft_rc == CMD_RESULT_NOT_LEADER ||
-        raft_rc == CMD_RESULT_REQUEST_CANCELLED) {
-        int32_t old_leader_id = leader_id_;
-        leader_id_ = get_leader_id();
+    if (is_leader_change(raft_rc)) {
+        int32_t old_leader_id = leader_id_.load();
+        int32_t new_leader_id = get_leader_id();
+        leader_id_ = new_leader_id;
 
         std::cerr << "INFO: leader changed from " << old_leader_id << " to "
-                  << leader_id_ << std::endl;
+                  << new_leader_id << std::endl;
         return true;
     }
 
     return false;
 }
 
-rpc_read_result client::get(const std::vector<uint8_t>& key) {
-    return clients_.find(read_policy_->next_server())
-        ->second.call(RPC_SPLINTERDB_GET, key)
-        .as<rpc_read_result>();
+void client::find_leader_async() {
+    bool expected = false;
+    if (finding_leader_.compare_exchange_strong(expected, true)) {
+        ask_for_leader_async(0);
+    }
 }
 
-rpc_mutation_result client::put(const std::vector<uint8_t>& key,
-                                const std::vector<uint8_t>& value) {
-    rpc_mutation_result result;
+void client::ask_for_leader_async(uint32_t attempt) {
+    // Like `get_leader_id`, every server is asked up to `num_retries_`
+    // times, but a request that finds no live leader is sent again to the
+    // next server after a backoff, rather than sleeping.
+    size_t max_attempts = clients_.size() * num_retries_;
+    if (attempt >= max_attempts) {
+        std::cerr << "WARNING: failed to find the leader" << std::endl;
+        finding_leader_ = false;
+        return;
+    }
+
+    auto next_attempt = std::make_shared<uint32_t>(attempt);
+    auto server_of = [this](uint32_t n) {
+        return std::next(clients_.begin(), n % clients_.size())->first;
+    };
+
+    async_dispatcher::operation op;
+    op.send_ = [this, next_attempt, server_of]() {
+        return handle(server_of(*next_attempt)).async_call(RPC_GET_LEADER_ID);
+    };
+    op.on_reply_ = [this, next_attempt, max_attempts](
+                       async_dispatcher::reply& reply)
+        -> std::optional<std::chrono::milliseconds> {
+        int32_t new_leader_id = reply.get().as<int32_t>();
+        if (new_leader_id == GET_LEADER_NO_LIVE_LEADER) {
+            if (++*next_attempt < max_attempts) {
+                std::cerr << "WARNING: no live leader, retrying..."
+                          << std::endl;
+                return LEADER_CHANGE_BACKOFF;
+            }
+
+            std::cerr << "WARNING: failed to find the leader" << std::endl;
+            finding_leader_ = false;
+            return std::nullopt;
+        }
+
+        int32_t old_leader_id = leader_id_.exchange(new_leader_id);
+        std::cerr << "INFO: leader changed from " << old_leader_id << " to "
+                  << new_leader_id << std::endl;
+        finding_leader_ = false;
+        return std::nullopt;
+    };
+    op.on_error_ = [this, next_attempt](std::exception_ptr) {
+        ask_for_leader_async(*next_attempt + 1);
+    };
+
+    try {
+        dispatcher_.submit(std::move(op));
+    } catch (const std::exception& e) {
+        std::cerr << "WARNING: failed to ask for the leader. Reason: "
+                  << e.what() << std::endl;
+        finding_leader_ = false;
+    }
+}
+
+void client::note_log_index(raft_log_index idx) {
+    raft_log_index seen = last_seen_idx_.load();
+    while (seen < idx && !last_seen_idx_.compare_exchange_weak(seen, idx)) {
+    }
+}
+
+rpc_read_result client::get(const std::vector<uint8_t>& key,
+                            read_consistency consistency) {
+    if (consistency == read_consistency::STALE) {
+        rpc_read_result result;
+        raft_log_index min_idx = last_seen_idx_.load();
+
+        std::shared_ptr<value_cache> cache = std::atomic_load(&value_cache_);
+        value_cache::fill_position fill{};
+        if (cache) {
+            if (cache->lookup(key, std::get<0>(result))) {
+                return result;
+            }
+
+            // The value must be at least as new as the cache.
+            fill = cache->start_fill();
+            min_idx = std::max(min_idx, fill.through_);
+        }
+
+        // Any replica that has applied our latest write will do. One that is
+        // still behind after a short wait sends us to the leader instead.
+        std::shared_ptr<latency_tracker> latency =
+            std::atomic_load(&read_latency_);
+        if (latency) {
+            result = hedged_get(key, min_idx, *latency);
+        } else {
+            int32_t srv_id = read_policy_->next_server();
+            read_feedback feedback(*read_policy_, srv_id);
+            result = handle(srv_id)
+                         .call(RPC_SPLINTERDB_GET, key, min_idx)
+                         .as<rpc_read_result>();
+            // A replica that is behind answers late rather than failing, and
+            // its latency says as much.
+            feedback.done(true);
+        }
+
+        if (std::get<1>(result) == CMD_RESULT_TIMEOUT) {
+            result = get_leader_handle()
+                         .call(RPC_SPLINTERDB_GET, key, min_idx)
+                         .as<rpc_read_result>();
+        }
+
+        if (cache && std::get<1>(result) == 0) {
+            cache->insert(key, std::get<0>(result), fill);
+        }
+
+        return result;
+    }
+
+    rpc_read_result result;
     for (uint16_t i = 0; i < num_retries_; ++i) {
         result = get_leader_handle()
-                     .call(RPC_SPLINTERDB_PUT, key, value)
-                     .as<rpc_mutation_result>();
+                     .call(RPC_SPLINTERDB_CONSISTENT_GET, key,
+                           static_cast<uint8_t>(consistency))
+                     .as<rpc_read_result>();
 
-        if (was_accepted(result)) {
-            break;
-        } else if (get_nuraft_return_code(result) == CMD_RESULT_WEIRD_CASE) {
-            std::string k(key.begin(), key.end());
-            std::cout << "WARNING: weird case. Verify that the key exists: "
-                      << k << std::endl;
-            std::get<1>(result) = 0;
-            break;
-        } else if (try_handle_leader_change(get_nuraft_return_code(result))) {
+        if (try_handle_leader_change(std::get<1>(result))) {
             std::cerr << "WARNING: leader changed, retrying..." << std::endl;
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        } else {
+            break;
         }
     }
 
     return result;
 }
 
-rpc_mutation_result client::update(const std::vector<uint8_t>& key,
-                                   const std::vector<uint8_t>& value) {
+rpc_read_result client::hedged_get(const std::vector<uint8_t>& key,
+                                   raft_log_index min_idx,
+                                   latency_tracker& latency) {
+    using clock = std::chrono::steady_clock;
+    clock::time_point deadline =
+        clock::now() + std::chrono::milliseconds(timeout_ms_);
+
+    int32_t first_id = read_policy_->next_server();
+    read_feedback first_feedback(*read_policy_, first_id);
+    auto first = handle(first_id).async_call(RPC_SPLINTERDB_GET, key, min_idx);
+
+    // No hedge until enough latencies have been seen to know what is slow.
+    std::chrono::microseconds delay = latency.value();
+    int32_t second_id = first_id;
+    if (delay.count() > 0 &&
+        first.wait_for(delay) != std::future_status::ready) {
+        for (int i = 0; i < HEDGE_PICK_ATTEMPTS && second_id == first_id;
+             ++i) {
+            second_id = read_policy_->next_server();
+        }
+    }
+
+    if (second_id == first_id) {
+        if (first.wait_until(deadline) != std::future_status::ready) {
+            throw std::runtime_error("read timed out");
+        }
+
+        rpc_read_result result = first.get().as<rpc_read_result>();
+        latency.record(first_feedback.done(true));
+        return result;
+    }
+
+    hedges_issued_++;
+    read_feedback second_feedback(*read_policy_, second_id);
+    auto second =
+        handle(second_id).async_call(RPC_SPLINTERDB_GET, key, min_idx);
+
+    // rpclib futures cannot be waited on together, so take turns. Only the
+    // winner's latency is a sample; the loser is abandoned, and the policy
+    // only learns that it took at least as long as it had so far.
+    while (clock::now() < deadline) {
+        if (first.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready) {
+            second_feedback.abandon();
+            rpc_read_result result = first.get().as<rpc_read_result>();
+            latency.record(first_feedback.done(true));
+            return result;
+        }
+
+        if (second.wait_for(HEDGE_POLL_INTERVAL) ==
+            std::future_status::ready) {
+            hedges_won_++;
+            first_feedback.abandon();
+            rpc_read_result result = second.get().as<rpc_read_result>();
+            latency.record(second_feedback.done(true));
+            return result;
+        }
+    }
+
+    throw std::runtime_error("read timed out");
+}
+
+void client::enable_hedged_reads(double percentile) {
+    std::atomic_store(&read_latency_,
+                      std::make_shared<latency_tracker>(percentile));
+}
+
+void client::disable_hedged_reads() {
+    std::atomic_store(&read_latency_, std::shared_ptr<latency_tracker>());
+}
+
+hedge_stats client::get_hedge_stats() const {
+    return hedge_stats{hedges_issued_.load(), hedges_won_.load()};
+}
+
+void client::enable_value_cache(size_t max_bytes,
+                                std::chrono::milliseconds refresh_interval,
+                                std::chrono::milliseconds lease) {
+    std::lock_guard<std::mutex> control_lk(cache_control_lock_);
+    stop_value_cache();
+
+    auto cache = std::make_shared<value_cache>(max_bytes, lease);
+    std::atomic_store(&value_cache_, cache);
+
+    std::lock_guard<std::mutex> lk(cache_refresher_lock_);
+    stop_cache_refresher_ = false;
+    cache_refresher_ = std::thread([this, cache, refresh_interval]() {
+        std::unique_lock<std::mutex> refresher_lk(cache_refresher_lock_);
+        while (!stop_cache_refresher_) {
+            refresher_lk.unlock();
+            refresh_value_cache(*cache);
+            refresher_lk.lock();
+
+            cache_refresher_cv_.wait_for(refresher_lk, refresh_interval,
+                                         [this] {
+                                             return stop_cache_refresher_;
+                                         });
+        }
+    });
+}
+
+void client::disable_value_cache() {
+    std::lock_guard<std::mutex> control_lk(cache_control_lock_);
+    stop_value_cache();
+}
+
+void client::stop_value_cache() {
+    std::thread refresher;
+    {
+        std::lock_guard<std::mutex> lk(cache_refresher_lock_);
+        stop_cache_refresher_ = true;
+        refresher = std::move(cache_refresher_);
+    }
+    cache_refresher_cv_.notify_all();
+
+    if (refresher.joinable()) {
+        refresher.join();
+    }
+    std::atomic_store(&value_cache_, std::shared_ptr<value_cache>());
+}
+
+void client::reset_value_cache() {
+    std::shared_ptr<value_cache> cache = std::atomic_load(&value_cache_);
+    if (cache) {
+        cache->clear();
+    }
+}
+
+value_cache_stats client::get_value_cache_stats() const {
+    std::shared_ptr<value_cache> cache = std::atomic_load(&value_cache_);
+    return cache ? cache->get_stats() : value_cache_stats{};
+}
+
+void client::refresh_value_cache(value_cache& cache) {
+    // There is no way for the server to push changes to us, so pull them,
+    // as many calls in a row as it takes to catch up.
+    try {
+        while (true) {
+            auto [keys, through_idx, complete] =
+                get_leader_handle()
+                    .call(RPC_SPLINTERDB_GET_CHANGES, cache.through(),
+                          CACHE_CHANGES_PER_CALL)
+                    .as<rpc_changes_result>();
+
+            if (!complete) {
+                cache.reset(through_idx);
+                return;
+            }
+
+            cache.apply_changes(keys, through_idx);
+            if (keys.size() < CACHE_CHANGES_PER_CALL) {
+                return;
+            }
+        }
+    } catch (const std::exception& e) {
+        // Cached values stop being served once the lease runs out.
+        std::cerr << "WARNING: failed to refresh the value cache. Reason: "
+                  << e.what() << std::endl;
+    }
+}
+
+void client::forget_cached(const std::vector<std::vector<uint8_t>>& keys) {
+    std::shared_ptr<value_cache> cache = std::atomic_load(&value_cache_);
+    if (cache) {
+        cache->invalidate(keys);
+    }
+}
+
+std::vector<rpc_read_result> client::multi_get(
+    const std::vector<std::vector<uint8_t>>& keys) {
+    if (keys.empty()) {
+        return {};
+    }
+
+    size_t num_groups = std::min(clients_.size(), keys.size());
+    size_t group_size = (keys.size() + num_groups - 1) / num_groups;
+
+    std::vector<std::vector<std::vector<uint8_t>>> groups;
+    std::vector<std::future<clmdep_msgpack::object_handle>> pending;
+    std::vector<read_feedback> feedback;
+    for (size_t begin = 0; begin < keys.size(); begin += group_size) {
+        size_t end = std::min(begin + group_size, keys.size());
+        groups.emplace_back(keys.begin() + begin, keys.begin() + end);
+
+        int32_t srv_id = read_policy_->next_server();
+        feedback.emplace_back(*read_policy_, srv_id);
+        pending.push_back(handle(srv_id).async_call(
+            RPC_SPLINTERDB_MULTI_GET, groups.back(), last_seen_idx_.load()));
+    }
+
+    std::vector<rpc_read_result> results;
+    results.reserve(keys.size());
+    for (size_t i = 0; i < pending.size(); ++i) {
+        auto group_results =
+            pending[i].get().get().as<std::vector<rpc_read_result>>();
+
+        feedback[i].done(true);
+
+        // A replica that has not caught up with our latest write fails the
+        // whole group; read it from the leader instead.
+        if (!group_results.empty() &&
+            std::get<1>(group_results.front()) == CMD_RESULT_TIMEOUT) {
+            group_results = get_leader_handle()
+                                .call(RPC_SPLINTERDB_MULTI_GET, groups[i],
+                                      last_seen_idx_.load())
+                                .as<std::vector<rpc_read_result>>();
+        }
+
+        std::move(group_results.begin(), group_results.end(),
+                  std::back_inserter(results));
+    }
+
+    return results;
+}
+
+scan_iterator client::scan(const std::vector<uint8_t>& start_key,
+                           const std::vector<uint8_t>& end_key,
+                           uint32_t page_entries, uint64_t page_bytes) {
+    // Like a STALE get, any replica that has applied our latest write will
+    // do. One that is still behind after a short wait fails the first page,
+    // and the leader is scanned instead.
+    raft_log_index min_idx = last_seen_idx_.load();
+    try {
+        return scan_iterator(handle(read_policy_->next_server()), start_key,
+                             end_key, page_entries, page_bytes, min_idx);
+    } catch (const std::runtime_error&) {
+        return scan_iterator(get_leader_handle(), start_key, end_key,
+                             page_entries, page_bytes, min_idx);
+    }
+}
+
+template <typename... Args>
+rpc_mutation_result client::mutate(const std::string& rpc_name,
+                                   const Args&... args) {
     rpc_mutation_result result;
     for (uint16_t i = 0; i < num_retries_; ++i) {
         result = get_leader_handle()
-                     .call(RPC_SPLINTERDB_UPDATE, key, value)
-                     .as<rpc_mutation_result>();
+                     .call(rpc_name, args...)
+                     .template as<rpc_mutation_result>();
 
         if (was_accepted(result)) {
+            note_log_index(get_log_index(result));
             break;
-        } else if (get_nuraft_return_code(result) == CMD_RESULT_WEIRD_CASE) {
-            std::string k(key.begin(), key.end());
-            std::cout << "WARNING: weird case. Verify that the key exists: "
-                      << k << std::endl;
-            std::get<1>(result) = 0;
+        } else if (!try_handle_leader_change(get_nuraft_return_code(result))) {
+            // Only a write that never reached a leader is sure not to have
+            // been applied. After a timeout or a failure it may or may not
+            // have been, so sending it again could apply it twice; the
+            // caller gets to decide.
             break;
-        } else if (try_handle_leader_change(get_nuraft_return_code(result))) {
-            std::cerr << "WARNING: leader changed, retrying..." << std::endl;
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
+
+        std::cerr << "WARNING: leader changed, retrying..." << std::endl;
+        std::this_thread::sleep_for(LEADER_CHANGE_BACKOFF);
     }
 
     return result;
 }
 
+rpc_mutation_result client::put(const std::vector<uint8_t>& key,
+                                const std::vector<uint8_t>& value) {
+    auto result = mutate(RPC_SPLINTERDB_PUT, key, value);
+    forget_cached({key});
+    return result;
+}
+
+rpc_mutation_result client::update(const std::vector<uint8_t>& key,
+                                   const std::vector<uint8_t>& value) {
+    auto result = mutate(RPC_SPLINTERDB_UPDATE, key, value);
+    forget_cached({key});
+    return result;
+}
+
 rpc_mutation_result client::del(const std::vector<uint8_t>& key) {
-    rpc_mutation_result result;
-    for (uint16_t i = 0; i < num_retries_; ++i) {
-        result = get_leader_handle()
-                     .call(RPC_SPLINTERDB_DELETE, key)
-                     .as<rpc_mutation_result>();
+    auto result = mutate(RPC_SPLINTERDB_DELETE, key);
+    forget_cached({key});
+    return result;
+}
 
-        if (was_accepted(result)) {
-            break;
-        } else if (get_nuraft_return_code(result) == CMD_RESULT_WEIRD_CASE) {
-            std::string k(key.begin(), key.end());
-            std::cout << "WARNING: weird case. Verify that the key exists: "
-                      << k << std::endl;
-            std::get<1>(result) = 0;
-            break;
-        } else if (try_handle_leader_change(get_nuraft_return_code(result))) {
-            std::cerr << "WARNING: leader changed, retrying..." << std::endl;
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+rpc_mutation_result client::multi_put(
+    const std::vector<std::vector<uint8_t>>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+    if (keys.size() != values.size()) {
+        throw std::invalid_argument("number of keys and values must match");
+    }
+
+    auto result = mutate(RPC_SPLINTERDB_MULTI_PUT, keys, values);
+    forget_cached(keys);
+    return result;
+}
+
+rpc_mutation_result client::multi_del(
+    const std::vector<std::vector<uint8_t>>& keys) {
+    auto result = mutate(RPC_SPLINTERDB_MULTI_DELETE, keys);
+    forget_cached(keys);
+    return result;
+}
+
+// Whether a replica failed a read because it has not caught up with the
+// client's latest write.
+static bool is_behind(const rpc_read_result& result) {
+    return std::get<1>(result) == CMD_RESULT_TIMEOUT;
+}
+
+static bool is_behind(const std::vector<rpc_read_result>& results) {
+    return !results.empty() && is_behind(results.front());
+}
+
+template <typename Result, typename Arg>
+void client::stale_read_async(
+    int32_t srv_id, const std::string& rpc_name, const Arg& arg,
+    raft_log_index min_idx, std::function<void(Result)> on_result,
+    std::function<void(std::exception_ptr)> on_error) {
+    struct state {
+        std::optional<read_feedback> feedback_;
+        bool at_leader_ = false;
+    };
+    auto st = std::make_shared<state>();
+
+    async_dispatcher::operation op;
+    op.send_ = [this, st, srv_id, rpc_name, arg, min_idx]() {
+        if (st->at_leader_) {
+            return get_leader_handle().async_call(rpc_name, arg, min_idx);
+        }
+
+        st->feedback_.emplace(*read_policy_, srv_id);
+        return handle(srv_id).async_call(rpc_name, arg, min_idx);
+    };
+    op.on_reply_ = [st, on_result](async_dispatcher::reply& reply)
+        -> std::optional<std::chrono::milliseconds> {
+        Result result = reply.get().as<Result>();
+        if (!st->at_leader_) {
+            st->feedback_->done(true);
+            if (is_behind(result)) {
+                st->at_leader_ = true;
+                return std::chrono::milliseconds(0);
+            }
+        }
+
+        on_result(std::move(result));
+        return std::nullopt;
+    };
+    op.on_error_ = std::move(on_error);
+
+    dispatcher_.submit(std::move(op));
+}
+
+std::future<rpc_read_result> client::get_async(
+    const std::vector<uint8_t>& key, read_consistency consistency) {
+    auto done = std::make_shared<std::promise<rpc_read_result>>();
+    std::future<rpc_read_result> result = done->get_future();
+    auto on_error = [done](std::exception_ptr e) { done->set_exception(e); };
+
+    if (consistency == read_consistency::STALE) {
+        raft_log_index min_idx = last_seen_idx_.load();
+
+        // Same as `get`.
+        std::shared_ptr<value_cache> cache = std::atomic_load(&value_cache_);
+        value_cache::fill_position fill{};
+        if (cache) {
+            rpc_read_result cached;
+            if (cache->lookup(key, std::get<0>(cached))) {
+                done->set_value(std::move(cached));
+                return result;
+            }
+
+            fill = cache->start_fill();
+            min_idx = std::max(min_idx, fill.through_);
+        }
+
+        stale_read_async<rpc_read_result>(
+            read_policy_->next_server(), RPC_SPLINTERDB_GET, key, min_idx,
+            [done, cache, key, fill](rpc_read_result read) {
+                if (cache && std::get<1>(read) == 0) {
+                    cache->insert(key, std::get<0>(read), fill);
+                }
+                done->set_value(std::move(read));
+            },
+            on_error);
+        return result;
+    }
+
+    async_dispatcher::operation op;
+    op.send_ = [this, key, consistency]() {
+        return get_leader_handle().async_call(
+            RPC_SPLINTERDB_CONSISTENT_GET, key,
+            static_cast<uint8_t>(consistency));
+    };
+    op.on_reply_ = [this, done, attempts = uint16_t(0)](
+                       async_dispatcher::reply& reply) mutable
+        -> std::optional<std::chrono::milliseconds> {
+        auto read = reply.get().as<rpc_read_result>();
+        if (is_leader_change(std::get<1>(read))) {
+            find_leader_async();
+            if (++attempts < num_retries_) {
+                std::cerr << "WARNING: leader changed, retrying..."
+                          << std::endl;
+                return LEADER_CHANGE_BACKOFF;
+            }
         }
+
+        done->set_value(std::move(read));
+        return std::nullopt;
+    };
+    op.on_error_ = on_error;
+
+    dispatcher_.submit(std::move(op));
+    return result;
+}
+
+std::future<std::vector<rpc_read_result>> client::multi_get_async(
+    const std::vector<std::vector<uint8_t>>& keys) {
+    struct state {
+        std::promise<std::vector<rpc_read_result>> promise_;
+        std::vector<std::vector<rpc_read_result>> groups_;
+        size_t remaining_ = 0;
+        bool failed_ = false;
+    };
+    auto st = std::make_shared<state>();
+    std::future<std::vector<rpc_read_result>> result =
+        st->promise_.get_future();
+
+    if (keys.empty()) {
+        st->promise_.set_value({});
+        return result;
+    }
+
+    // Split the keys the same way as `multi_get`. The groups' replies are
+    // all handled on the dispatcher's thread, so the state needs no lock.
+    size_t num_groups = std::min(clients_.size(), keys.size());
+    size_t group_size = (keys.size() + num_groups - 1) / num_groups;
+    st->remaining_ = (keys.size() + group_size - 1) / group_size;
+    st->groups_.resize(st->remaining_);
+
+    raft_log_index min_idx = last_seen_idx_.load();
+    for (size_t i = 0; i * group_size < keys.size(); ++i) {
+        size_t begin = i * group_size;
+        size_t end = std::min(begin + group_size, keys.size());
+        std::vector<std::vector<uint8_t>> group(keys.begin() + begin,
+                                                keys.begin() + end);
+
+        stale_read_async<std::vector<rpc_read_result>>(
+            read_policy_->next_server(), RPC_SPLINTERDB_MULTI_GET, group,
+            min_idx,
+            [st, i](std::vector<rpc_read_result> group_results) {
+                st->groups_[i] = std::move(group_results);
+                if (--st->remaining_ > 0 || st->failed_) {
+                    return;
+                }
+
+                std::vector<rpc_read_result> results;
+                for (auto& g : st->groups_) {
+                    std::move(g.begin(), g.end(), std::back_inserter(results));
+                }
+                st->promise_.set_value(std::move(results));
+            },
+            [st](std::exception_ptr e) {
+                if (!st->failed_) {
+                    st->failed_ = true;
+                    st->promise_.set_exception(e);
+                }
+            });
     }
 
     return result;
 }
 
+template <typename... Args>
+std::future<rpc_mutation_result> client::mutate_async(
+    std::vector<std::vector<uint8_t>> written, const std::string& rpc_name,
+    const Args&... args) {
+    auto done = std::make_shared<std::promise<rpc_mutation_result>>();
+    std::future<rpc_mutation_result> result = done->get_future();
+
+    async_dispatcher::operation op;
+    op.send_ = [this, rpc_name, args...]() {
+        return get_leader_handle().async_call(rpc_name, args...);
+    };
+    // Same as `mutate`, except that neither finding nor waiting for a new
+    // leader blocks the dispatcher.
+    op.on_reply_ = [this, done, written, attempts = uint16_t(0)](
+                       async_dispatcher::reply& reply) mutable
+        -> std::optional<std::chrono::milliseconds> {
+        auto mutation = reply.get().as<rpc_mutation_result>();
+        ++attempts;
+
+        if (was_accepted(mutation)) {
+            note_log_index(get_log_index(mutation));
+        } else if (is_leader_change(get_nuraft_return_code(mutation))) {
+            find_leader_async();
+            if (attempts < num_retries_) {
+                std::cerr << "WARNING: leader changed, retrying..."
+                          << std::endl;
+                return LEADER_CHANGE_BACKOFF;
+            }
+        }
+
+        forget_cached(written);
+        done->set_value(std::move(mutation));
+        return std::nullopt;
+    };
+    op.on_error_ = [this, done, written](std::exception_ptr e) {
+        forget_cached(written);
+        done->set_exception(e);
+    };
+
+    dispatcher_.submit(std::move(op));
+    return result;
+}
+
+std::future<rpc_mutation_result> client::put_async(
+    const std::vector<uint8_t>& key, const std::vector<uint8_t>& value) {
+    return mutate_async({key}, RPC_SPLINTERDB_PUT, key, value);
+}
+
+std::future<rpc_mutation_result> client::update_async(
+    const std::vector<uint8_t>& key, const std::vector<uint8_t>& value) {
+    return mutate_async({key}, RPC_SPLINTERDB_UPDATE, key, value);
+}
+
+std::future<rpc_mutation_result> client::del_async(
+    const std::vector<uint8_t>& key) {
+    return mutate_async({key}, RPC_SPLINTERDB_DELETE, key);
+}
+
 std::vector<std::tuple<int32_t, std::string>> client::get_all_servers() {
-    for (auto& [srv_id, c] : clients_) {
+    for (auto& [srv_id, pool] : clients_) {
         try {
-            return c.call(RPC_GET_ALL_SERVERS)
+            return handle(srv_id)
+                .call(RPC_GET_ALL_SERVERS)
                 .as<std::vector<std::tuple<int32_t, std::string>>>();
         } catch (const std::exception& e) {
             std::cerr << "WARNING: failed to connect to " << srv_id
@@ -203,10 +964,11 @@ std::vector<std::tuple<int32_t, std::string>> client::get_all_servers() {
 
 int32_t client::get_leader_id() {
     size_t delay_ms = 100;
-    for (auto& [srv_id, c] : clients_) {
+    for (auto& [srv_id, pool] : clients_) {
         try {
             for (uint16_t i = 0; i < num_retries_; ++i) {
-                int32_t leader_id = c.call(RPC_GET_LEADER_ID).as<int32_t>();
+                int32_t leader_id =
+                    handle(srv_id).call(RPC_GET_LEADER_ID).as<int32_t>();
                 if (leader_id != GET_LEADER_NO_LIVE_LEADER) {
                     return leader_id;
                 }
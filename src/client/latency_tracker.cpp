@@ -0,0 +1,51 @@
+#include "client/latency_tracker.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace replicated_splinterdb {
+
+latency_tracker::latency_tracker(double percentile, size_t window,
+                                 size_t refresh)
+    : percentile_(percentile),
+      refresh_(std::max<size_t>(refresh, 1)),
+      samples_(),
+      next_(0),
+      count_(0),
+      value_us_(0),
+      lock_() {
+    if (percentile <= 0 || percentile >= 1) {
+        throw std::invalid_argument("percentile must be in (0, 1)");
+    }
+    if (window == 0) {
+        throw std::invalid_argument("window must not be empty");
+    }
+
+    samples_.resize(window);
+}
+
+void latency_tracker::record(std::chrono::microseconds latency) {
+    std::lock_guard<std::mutex> l(lock_);
+    samples_[next_] = latency.count();
+    next_ = (next_ + 1) % samples_.size();
+    ++count_;
+
+    if (count_ % refresh_ != 0) {
+        return;
+    }
+
+    std::vector<int64_t> window(
+        samples_.begin(),
+        samples_.begin() +
+            static_cast<std::ptrdiff_t>(std::min(count_, samples_.size())));
+    auto rank = static_cast<std::ptrdiff_t>(
+        percentile_ * static_cast<double>(window.size() - 1));
+    std::nth_element(window.begin(), window.begin() + rank, window.end());
+    value_us_ = window[static_cast<size_t>(rank)];
+}
+
+std::chrono::microseconds latency_tracker::value() const {
+    return std::chrono::microseconds(value_us_.load());
+}
+
+}  // namespace replicated_splinterdb
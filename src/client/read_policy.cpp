@@ -0,0 +1,142 @@
+#include "client/read_policy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace replicated_splinterdb {
+
+round_robin_read_policy::round_robin_read_policy(
+    const std::vector<int32_t>& server_ids)
+    : server_ids_(server_ids), next_(0) {
+    if (server_ids_.empty()) {
+        throw std::invalid_argument("read policy needs at least one server");
+    }
+}
+
+int32_t round_robin_read_policy::next_server() {
+    size_t turn = next_.fetch_add(1, std::memory_order_relaxed);
+    return server_ids_[turn % server_ids_.size()];
+}
+
+latency_aware_read_policy::latency_aware_read_policy(
+    const std::vector<int32_t>& server_ids,
+    std::chrono::microseconds failure_penalty, std::chrono::microseconds decay)
+    : failure_penalty_us_(static_cast<double>(failure_penalty.count())),
+      decay_us_(static_cast<double>(decay.count())),
+      server_ids_(server_ids),
+      stats_() {
+    if (server_ids_.empty()) {
+        throw std::invalid_argument("read policy needs at least one server");
+    }
+    if (decay.count() <= 0) {
+        throw std::invalid_argument("decay must be positive");
+    }
+
+    int64_t now = clock_us();
+    for (int32_t id : server_ids_) {
+        stats_[id].updated_us_ = now;
+    }
+}
+
+int64_t latency_aware_read_policy::clock_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               clock::now().time_since_epoch())
+        .count();
+}
+
+double latency_aware_read_policy::decay_weight(int64_t updated_us,
+                                               int64_t now_us) const {
+    int64_t idle_us = std::max<int64_t>(0, now_us - updated_us);
+    return std::exp(-static_cast<double>(idle_us) / decay_us_);
+}
+
+double latency_aware_read_policy::load(const server_stats& stats,
+                                       int64_t now_us) const {
+    // A floor of a microsecond keeps reads in flight counting for servers
+    // with no latency on record yet.
+    double cost = std::max(
+        1.0, stats.cost_us_.load(std::memory_order_relaxed) *
+                 decay_weight(stats.updated_us_.load(std::memory_order_relaxed),
+                              now_us));
+    return cost * (stats.outstanding_.load(std::memory_order_relaxed) + 1);
+}
+
+int32_t latency_aware_read_policy::next_server() {
+    if (server_ids_.size() == 1) {
+        return server_ids_.front();
+    }
+
+    // Two distinct candidates, uniformly at random. Every thread has a
+    // generator of its own.
+    thread_local std::minstd_rand rng(std::random_device{}());
+    std::uniform_int_distribution<size_t> pick(0, server_ids_.size() - 1);
+    size_t first = pick(rng);
+    size_t second = pick(rng);
+    while (second == first) {
+        second = pick(rng);
+    }
+
+    int64_t now = clock_us();
+    int32_t a = server_ids_[first];
+    int32_t b = server_ids_[second];
+    return load(stats_.at(a), now) <= load(stats_.at(b), now) ? a : b;
+}
+
+void latency_aware_read_policy::on_read_start(int32_t server_id) {
+    stats_.at(server_id).outstanding_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void latency_aware_read_policy::end_outstanding(server_stats& stats) {
+    uint32_t outstanding = stats.outstanding_.load(std::memory_order_relaxed);
+    while (outstanding > 0 &&
+           !stats.outstanding_.compare_exchange_weak(
+               outstanding, outstanding - 1, std::memory_order_relaxed)) {
+    }
+}
+
+void latency_aware_read_policy::on_read_end(int32_t server_id,
+                                            std::chrono::microseconds latency,
+                                            bool ok) {
+    server_stats& stats = stats_.at(server_id);
+    end_outstanding(stats);
+
+    int64_t now = clock_us();
+    double sample = static_cast<double>(latency.count());
+    if (!ok) {
+        sample = std::max(sample, failure_penalty_us_);
+    }
+
+    // Weigh the previous estimate by how recent it is, but take any slower
+    // observation at once, so that a degrading server is avoided right away.
+    double weight = decay_weight(
+        stats.updated_us_.load(std::memory_order_relaxed), now);
+    double cost = stats.cost_us_.load(std::memory_order_relaxed);
+    double updated;
+    do {
+        updated =
+            sample > cost ? sample : cost * weight + sample * (1 - weight);
+    } while (!stats.cost_us_.compare_exchange_weak(cost, updated,
+                                                   std::memory_order_relaxed));
+    stats.updated_us_.store(now, std::memory_order_relaxed);
+}
+
+void latency_aware_read_policy::on_read_abandoned(
+    int32_t server_id, std::chrono::microseconds elapsed) {
+    server_stats& stats = stats_.at(server_id);
+    end_outstanding(stats);
+
+    // Compare with the estimate as decayed by now, which is what the sample
+    // replaces if it is higher.
+    int64_t now = clock_us();
+    double sample = static_cast<double>(elapsed.count());
+    double weight = decay_weight(
+        stats.updated_us_.load(std::memory_order_relaxed), now);
+    if (sample > stats.cost_us_.load(std::memory_order_relaxed) * weight) {
+        stats.cost_us_.store(sample, std::memory_order_relaxed);
+        stats.updated_us_.store(now, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace replicated_splinterdb
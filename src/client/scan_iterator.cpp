@@ -0,0 +1,60 @@
+#include "client/scan_iterator.h"
+
+#include "common/rpc.h"
+
+namespace replicated_splinterdb {
+
+scan_iterator::scan_iterator(rpc::client& cl,
+                             const std::vector<uint8_t>& start_key,
+                             const std::vector<uint8_t>& end_key,
+                             uint32_t page_entries, uint64_t page_bytes,
+                             raft_log_index min_log_idx)
+    : cl_(&cl),
+      start_key_(start_key),
+      end_key_(end_key),
+      page_entries_(page_entries),
+      page_bytes_(page_bytes),
+      min_log_idx_(min_log_idx),
+      page_(),
+      pos_(0),
+      next_page_(),
+      has_next_page_(false) {
+    prefetch({});
+    advance_page();
+}
+
+void scan_iterator::next() {
+    if (!valid()) {
+        return;
+    }
+
+    if (++pos_ == page_.size() && has_next_page_) {
+        advance_page();
+    }
+}
+
+void scan_iterator::prefetch(const std::vector<uint8_t>& continuation) {
+    next_page_ = cl_->async_call(RPC_SPLINTERDB_SCAN, start_key_, end_key_,
+                                 page_entries_, continuation, page_bytes_,
+                                 min_log_idx_);
+    has_next_page_ = true;
+}
+
+void scan_iterator::advance_page() {
+    auto [entries, next_key, rc] =
+        next_page_.get().get().as<rpc_scan_result>();
+    has_next_page_ = false;
+
+    if (rc != 0) {
+        throw std::runtime_error("scan failed, rc=" + std::to_string(rc));
+    }
+
+    page_ = std::move(entries);
+    pos_ = 0;
+
+    if (!next_key.empty()) {
+        prefetch(next_key);
+    }
+}
+
+}  // namespace replicated_splinterdb
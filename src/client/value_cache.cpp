@@ -0,0 +1,212 @@
+#include "client/value_cache.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace replicated_splinterdb {
+
+static size_t entry_size(size_t key_size, size_t value_size) {
+    return key_size + value_size + value_cache::ENTRY_OVERHEAD;
+}
+
+value_cache::value_cache(size_t max_bytes, std::chrono::milliseconds lease)
+    : max_bytes_(max_bytes),
+      lease_(lease),
+      slots_(),
+      free_(),
+      hand_(0),
+      index_(),
+      bytes_(0),
+      epoch_(0),
+      through_(0),
+      renewed_us_(0),
+      hits_(0),
+      misses_(0),
+      inserts_(0),
+      evictions_(0),
+      invalidations_(0),
+      resets_(0),
+      lock_() {
+    // Nothing is served until the first refresh.
+    renewed_us_ = clock_us() -
+                  std::chrono::duration_cast<std::chrono::microseconds>(lease_)
+                      .count() -
+                  1;
+}
+
+int64_t value_cache::clock_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               clock::now().time_since_epoch())
+        .count();
+}
+
+void value_cache::renew_lease() { renewed_us_ = clock_us(); }
+
+bool value_cache::lookup(const std::vector<uint8_t>& key,
+                         std::vector<uint8_t>& value) {
+    int64_t lease_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(lease_).count();
+    if (clock_us() - renewed_us_.load(std::memory_order_relaxed) > lease_us) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::string k(key.begin(), key.end());
+    std::shared_lock<std::shared_mutex> lk(lock_);
+    auto it = index_.find(k);
+    if (it == index_.end()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    entry& e = slots_[it->second];
+    e.referenced_.store(true, std::memory_order_relaxed);
+    value = e.value_;
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+value_cache::fill_position value_cache::start_fill() const {
+    std::shared_lock<std::shared_mutex> lk(lock_);
+    return fill_position{epoch_, through_};
+}
+
+void value_cache::insert(const std::vector<uint8_t>& key,
+                         const std::vector<uint8_t>& value,
+                         const fill_position& pos) {
+    size_t size = entry_size(key.size(), value.size());
+    if (size > max_bytes_) {
+        return;
+    }
+
+    std::string k(key.begin(), key.end());
+    std::unique_lock<std::shared_mutex> lk(lock_);
+    if (pos.epoch_ != epoch_) {
+        return;
+    }
+
+    auto it = index_.find(k);
+    if (it != index_.end()) {
+        erase(it->second);
+    }
+    make_room(size);
+
+    size_t slot;
+    if (free_.empty()) {
+        slot = slots_.size();
+        slots_.emplace_back();
+    } else {
+        slot = free_.back();
+        free_.pop_back();
+    }
+
+    // A new entry starts unreferenced, so that keys read only once are the
+    // first to go.
+    entry& e = slots_[slot];
+    e.key_ = &index_.emplace(std::move(k), slot).first->first;
+    e.value_ = value;
+    e.referenced_.store(false, std::memory_order_relaxed);
+
+    bytes_ += size;
+    inserts_++;
+}
+
+void value_cache::invalidate(const std::vector<std::vector<uint8_t>>& keys) {
+    std::unique_lock<std::shared_mutex> lk(lock_);
+    erase_keys(keys);
+}
+
+void value_cache::apply_changes(const std::vector<std::vector<uint8_t>>& keys,
+                                raft_log_index through) {
+    // Both at once, so that a fill never pairs the old `through_` with the
+    // new epoch.
+    std::unique_lock<std::shared_mutex> lk(lock_);
+    if (!keys.empty()) {
+        erase_keys(keys);
+    }
+    through_ = std::max(through_, through);
+    renew_lease();
+}
+
+void value_cache::reset(raft_log_index through) {
+    std::unique_lock<std::shared_mutex> lk(lock_);
+    erase_all();
+    through_ = through;
+    renew_lease();
+}
+
+void value_cache::clear() {
+    std::unique_lock<std::shared_mutex> lk(lock_);
+    erase_all();
+}
+
+raft_log_index value_cache::through() const {
+    std::shared_lock<std::shared_mutex> lk(lock_);
+    return through_;
+}
+
+value_cache_stats value_cache::get_stats() const {
+    std::shared_lock<std::shared_mutex> lk(lock_);
+    value_cache_stats stats;
+    stats.hits_ = hits_.load(std::memory_order_relaxed);
+    stats.misses_ = misses_.load(std::memory_order_relaxed);
+    stats.inserts_ = inserts_;
+    stats.evictions_ = evictions_;
+    stats.invalidations_ = invalidations_;
+    stats.resets_ = resets_;
+    stats.entries_ = index_.size();
+    stats.bytes_ = bytes_;
+    return stats;
+}
+
+void value_cache::erase(size_t slot) {
+    entry& e = slots_[slot];
+    bytes_ -= entry_size(e.key_->size(), e.value_.size());
+    index_.erase(index_.find(*e.key_));
+
+    e.key_ = nullptr;
+    std::vector<uint8_t>().swap(e.value_);
+    free_.push_back(slot);
+}
+
+void value_cache::erase_keys(const std::vector<std::vector<uint8_t>>& keys) {
+    for (const auto& key : keys) {
+        auto it = index_.find(std::string(key.begin(), key.end()));
+        if (it != index_.end()) {
+            erase(it->second);
+            invalidations_++;
+        }
+    }
+
+    // Even a key that is not cached may have a fill in flight.
+    epoch_++;
+}
+
+void value_cache::erase_all() {
+    slots_.clear();
+    free_.clear();
+    index_.clear();
+    hand_ = 0;
+    bytes_ = 0;
+
+    epoch_++;
+    resets_++;
+}
+
+void value_cache::make_room(size_t size) {
+    while (bytes_ + size > max_bytes_ && !index_.empty()) {
+        size_t slot = hand_;
+        hand_ = (hand_ + 1) % slots_.size();
+
+        entry& e = slots_[slot];
+        if (e.key_ == nullptr ||
+            e.referenced_.exchange(false, std::memory_order_relaxed)) {
+            continue;
+        }
+
+        erase(slot);
+        evictions_++;
+    }
+}
+
+}  // namespace replicated_splinterdb
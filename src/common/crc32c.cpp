@@ -0,0 +1,99 @@
+#include "common/crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace replicated_splinterdb {
+
+// Reflected CRC32C polynomial.
+static constexpr uint32_t CRC32C_POLY = 0x82f63b78;
+
+using crc_tables = std::array<std::array<uint32_t, 256>, 8>;
+
+// Tables for slicing-by-8: `tables[k][b]` is the CRC of byte `b` followed by
+// `k` zero bytes.
+static constexpr crc_tables make_tables() {
+    crc_tables tables{};
+    for (uint32_t b = 0; b < 256; ++b) {
+        uint32_t crc = b;
+        for (int i = 0; i < 8; ++i) {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        }
+        tables[0][b] = crc;
+    }
+    for (size_t k = 1; k < tables.size(); ++k) {
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t prev = tables[k - 1][b];
+            tables[k][b] = (prev >> 8) ^ tables[0][prev & 0xff];
+        }
+    }
+    return tables;
+}
+
+static constexpr crc_tables TABLES = make_tables();
+
+uint32_t crc32c_portable(const void* data, size_t size, uint32_t crc) {
+    auto* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+
+    for (; size >= 8; size -= 8, p += 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        word ^= crc;
+        crc = TABLES[7][word & 0xff] ^ TABLES[6][(word >> 8) & 0xff] ^
+              TABLES[5][(word >> 16) & 0xff] ^ TABLES[4][(word >> 24) & 0xff] ^
+              TABLES[3][(word >> 32) & 0xff] ^ TABLES[2][(word >> 40) & 0xff] ^
+              TABLES[1][(word >> 48) & 0xff] ^ TABLES[0][word >> 56];
+    }
+    for (; size > 0; --size, ++p) {
+        crc = (crc >> 8) ^ TABLES[0][(crc ^ *p) & 0xff];
+    }
+
+    return ~crc;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2"))) static uint32_t crc32c_sse42(
+    const void* data, size_t size, uint32_t crc) {
+    auto* p = static_cast<const uint8_t*>(data);
+    uint64_t crc64 = ~crc;
+
+    for (; size >= 8; size -= 8, p += 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+
+    uint32_t crc32 = static_cast<uint32_t>(crc64);
+    for (; size > 0; --size, ++p) {
+        crc32 = _mm_crc32_u8(crc32, *p);
+    }
+
+    return ~crc32;
+}
+
+static const bool HAS_SSE42 = __builtin_cpu_supports("sse4.2");
+
+#else
+
+static const bool HAS_SSE42 = false;
+
+#endif
+
+uint32_t crc32c(const void* data, size_t size, uint32_t crc) {
+#if defined(__x86_64__)
+    if (HAS_SSE42) {
+        return crc32c_sse42(data, size, crc);
+    }
+#endif
+    return crc32c_portable(data, size, crc);
+}
+
+bool crc32c_is_hardware_accelerated() { return HAS_SSE42; }
+
+}  // namespace replicated_splinterdb
@@ -14,4 +14,8 @@ bool was_accepted(const rpc_mutation_result& result) {
     return get_nuraft_return_code(result) == 0;
 }
 
+raft_log_index get_log_index(const rpc_mutation_result& result) {
+    return std::get<3>(result);
+}
+
 }  // namespace replicated_splinterdb
\ No newline at end of file
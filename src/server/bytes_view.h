@@ -0,0 +1,93 @@
+#ifndef REPLICATED_SPLINTERDB_BYTES_VIEW_H
+#define REPLICATED_SPLINTERDB_BYTES_VIEW_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "rpc/msgpack.hpp"
+#include "server/splinterdb_wrapper.h"
+
+namespace replicated_splinterdb {
+
+/**
+ * A borrowed byte string that msgpack reads and writes as BIN, the same wire
+ * format as `std::vector<uint8_t>`. Decoding points into the request that is
+ * being handled, and encoding copies straight from the referenced bytes, so
+ * RPC handlers can pass keys and values to and from SplinterDB without
+ * intermediate vectors.
+ *
+ * The referenced memory must stay valid until the handler has returned.
+ */
+struct bytes_view {
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+
+    bytes_view() = default;
+
+    bytes_view(slice s)
+        : data_(static_cast<const char*>(slice_data(s))),
+          size_(slice_length(s)) {}
+
+    slice to_slice() const { return slice_create(size_, data_); }
+};
+
+}  // namespace replicated_splinterdb
+
+namespace clmdep_msgpack {
+MSGPACK_API_VERSION_NAMESPACE(MSGPACK_DEFAULT_API_NS) {
+    namespace adaptor {
+
+    template <>
+    struct convert<replicated_splinterdb::bytes_view> {
+        const clmdep_msgpack::object& operator()(
+            const clmdep_msgpack::object& o,
+            replicated_splinterdb::bytes_view& v) const {
+            if (o.type == clmdep_msgpack::type::BIN) {
+                v.data_ = o.via.bin.ptr;
+                v.size_ = o.via.bin.size;
+            } else if (o.type == clmdep_msgpack::type::STR) {
+                v.data_ = o.via.str.ptr;
+                v.size_ = o.via.str.size;
+            } else {
+                throw clmdep_msgpack::type_error();
+            }
+
+            return o;
+        }
+    };
+
+    template <>
+    struct pack<replicated_splinterdb::bytes_view> {
+        template <typename Stream>
+        clmdep_msgpack::packer<Stream>& operator()(
+            clmdep_msgpack::packer<Stream>& o,
+            const replicated_splinterdb::bytes_view& v) const {
+            uint32_t size = clmdep_msgpack::checked_get_container_size(v.size_);
+            o.pack_bin(size);
+            o.pack_bin_body(v.data_, size);
+            return o;
+        }
+    };
+
+    template <>
+    struct object_with_zone<replicated_splinterdb::bytes_view> {
+        void operator()(clmdep_msgpack::object::with_zone& o,
+                        const replicated_splinterdb::bytes_view& v) const {
+            uint32_t size = clmdep_msgpack::checked_get_container_size(v.size_);
+            char* ptr = static_cast<char*>(
+                o.zone.allocate_align(size, MSGPACK_ZONE_ALIGNOF(char)));
+            if (size > 0) {
+                std::memcpy(ptr, v.data_, size);
+            }
+
+            o.type = clmdep_msgpack::type::BIN;
+            o.via.bin.ptr = ptr;
+            o.via.bin.size = size;
+        }
+    };
+
+    }  // namespace adaptor
+}  // MSGPACK_API_VERSION_NAMESPACE(MSGPACK_DEFAULT_API_NS)
+}  // namespace clmdep_msgpack
+
+#endif  // REPLICATED_SPLINTERDB_BYTES_VIEW_H
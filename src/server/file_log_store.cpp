@@ -0,0 +1,680 @@
+#include "file_log_store.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "common/crc32c.h"
+#include "log_pack.h"
+
+namespace replicated_splinterdb {
+
+using nuraft::buffer;
+using nuraft::cs_new;
+using nuraft::log_entry;
+using nuraft::ptr;
+
+// Every record is the size of the serialized entry, its CRC32C, its term and
+// then the serialized entry itself.
+static constexpr size_t RECORD_HEADER_SIZE =
+    sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint64_t);
+
+// A zero size marks the end of the records in a segment. One is written right
+// after every record, so that stale records beyond a truncation point are
+// never mistaken for live ones.
+static constexpr uint32_t END_OF_SEGMENT = 0;
+
+static const std::string SEGMENT_PREFIX = "segment-";
+static const std::string SEGMENT_SUFFIX = ".log";
+
+// Holds the start index of the log, so that compacted entries stay compacted
+// even if the segment holding them is still around.
+static const std::string START_FILE = "start";
+
+static std::string segment_path(const std::string& dir, uint64_t first_idx) {
+    char name[32];
+    snprintf(name, sizeof(name), "%020llu",
+             static_cast<unsigned long long>(first_idx));
+    return dir + "/" + SEGMENT_PREFIX + name + SEGMENT_SUFFIX;
+}
+
+/**
+ * @return `true` if `name` is the name of a segment, with the index of its
+ *         first entry in `first_idx`.
+ */
+static bool parse_segment_name(const std::string& name, uint64_t& first_idx) {
+    if (name.size() <= SEGMENT_PREFIX.size() + SEGMENT_SUFFIX.size() ||
+        name.compare(0, SEGMENT_PREFIX.size(), SEGMENT_PREFIX) != 0 ||
+        name.compare(name.size() - SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX.size(),
+                     SEGMENT_SUFFIX) != 0) {
+        return false;
+    }
+
+    const char* begin = name.data() + SEGMENT_PREFIX.size();
+    const char* end = name.data() + name.size() - SEGMENT_SUFFIX.size();
+    auto [ptr, ec] = std::from_chars(begin, end, first_idx);
+    return ec == std::errc() && ptr == end;
+}
+
+static std::runtime_error io_error(const std::string& what,
+                                   const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + strerror(errno));
+}
+
+static void pread_fully(int fd, void* buf, size_t len, uint64_t offset,
+                        const std::string& path) {
+    auto* out = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t n = pread(fd, out, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            throw io_error("Failed to read log segment", path);
+        }
+
+        out += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+}
+
+file_log_store::segment::segment(const std::string& path, uint64_t first_idx,
+                                 int fd, uint64_t capacity, uint64_t end)
+    : path_(path),
+      first_idx_(first_idx),
+      fd_(fd),
+      capacity_(capacity),
+      end_(end),
+      dirty_(false) {}
+
+file_log_store::segment::~segment() { close(fd_); }
+
+file_log_store::file_log_store(const std::string& dir, uint64_t segment_size,
+                               const log_sync_options& sync)
+    : dir_(dir),
+      segment_size_(segment_size),
+      segments_(),
+      index_(),
+      start_idx_(1),
+      dir_dirty_(false),
+      lock_(),
+      syncer_(sync, [this] { return sync_segments(); }) {
+    std::filesystem::create_directories(dir_);
+    recover();
+    syncer_.reset(start_idx_ + index_.size() - 1);
+}
+
+file_log_store::~file_log_store() { sync_segments(); }
+
+void file_log_store::recover() {
+    std::map<uint64_t, std::string> files;
+    for (const auto& file : std::filesystem::directory_iterator(dir_)) {
+        uint64_t first_idx;
+        if (parse_segment_name(file.path().filename().string(), first_idx)) {
+            files.emplace(first_idx, file.path().string());
+        }
+    }
+
+    bool broken = false;
+    std::vector<uint8_t> data;
+    for (const auto& [first_idx, path] : files) {
+        // Segments must follow each other without gaps; anything after a gap
+        // or after a torn record can't be trusted.
+        if (broken ||
+            (!segments_.empty() && first_idx != start_idx_ + index_.size())) {
+            broken = true;
+            unlink(path.c_str());
+            continue;
+        }
+
+        int fd = open(path.c_str(), O_RDWR);
+        if (fd < 0) {
+            throw io_error("Failed to open log segment", path);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw io_error("Failed to stat log segment", path);
+        }
+
+        uint64_t capacity = static_cast<uint64_t>(st.st_size);
+        uint64_t offset = 0;
+        while (offset + RECORD_HEADER_SIZE <= capacity) {
+            uint8_t header[RECORD_HEADER_SIZE];
+            pread_fully(fd, header, sizeof(header), offset, path);
+
+            uint32_t size;
+            uint32_t crc;
+            uint64_t term;
+            memcpy(&size, header, sizeof(size));
+            memcpy(&crc, header + sizeof(size), sizeof(crc));
+            memcpy(&term, header + sizeof(size) + sizeof(crc), sizeof(term));
+
+            if (size == END_OF_SEGMENT) {
+                break;
+            } else if (offset + RECORD_HEADER_SIZE + size > capacity) {
+                broken = true;
+                break;
+            }
+
+            // A crash can only tear records at the end of the newest
+            // segment, so only those are checked here; the others are
+            // checked whenever they are read.
+            if (first_idx == files.rbegin()->first) {
+                data.resize(size);
+                pread_fully(fd, data.data(), size, offset + RECORD_HEADER_SIZE,
+                            path);
+                if (crc32c(data.data(), size) != crc) {
+                    broken = true;
+                    break;
+                }
+            }
+
+            index_.push_back(
+                entry_location{offset + RECORD_HEADER_SIZE, size, crc, term});
+            offset += RECORD_HEADER_SIZE + size;
+        }
+
+        if (segments_.empty()) {
+            start_idx_ = first_idx;
+        }
+
+        segments_.emplace(first_idx, cs_new<segment>(path, first_idx, fd,
+                                                     capacity, offset));
+    }
+
+    // Drop what was compacted away but is still in the oldest segments.
+    uint64_t start_idx = read_start_index();
+    if (start_idx > start_idx_) {
+        uint64_t compacted = std::min<uint64_t>(start_idx - start_idx_,
+                                                index_.size());
+        index_.erase(index_.begin(),
+                     index_.begin() + static_cast<std::ptrdiff_t>(compacted));
+        while (!segments_.empty() &&
+               (index_.empty() || (segments_.size() > 1 &&
+                                   std::next(segments_.begin())->first <=
+                                       start_idx))) {
+            remove_segment(segments_.begin());
+        }
+        start_idx_ = start_idx;
+    }
+}
+
+uint64_t file_log_store::read_start_index() const {
+    std::string path = dir_ + "/" + START_FILE;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        throw io_error("Failed to open", path);
+    }
+
+    uint8_t data[sizeof(uint64_t) + sizeof(uint32_t)];
+    ssize_t n = pread(fd, data, sizeof(data), 0);
+    close(fd);
+    if (n != static_cast<ssize_t>(sizeof(data))) {
+        throw std::runtime_error("Corrupted start index in " + path);
+    }
+
+    uint64_t start_idx;
+    uint32_t crc;
+    memcpy(&start_idx, data, sizeof(start_idx));
+    memcpy(&crc, data + sizeof(start_idx), sizeof(crc));
+    if (crc32c(data, sizeof(start_idx)) != crc) {
+        throw std::runtime_error("Corrupted start index in " + path);
+    }
+
+    return start_idx;
+}
+
+void file_log_store::write_start_index(uint64_t start_idx) {
+    // Written aside and renamed over the old one, so that a crash leaves
+    // either of them in place.
+    std::string path = dir_ + "/" + START_FILE;
+    std::string tmp_path = path + ".tmp";
+
+    uint8_t data[sizeof(uint64_t) + sizeof(uint32_t)];
+    uint32_t crc = crc32c(&start_idx, sizeof(start_idx));
+    memcpy(data, &start_idx, sizeof(start_idx));
+    memcpy(data + sizeof(start_idx), &crc, sizeof(crc));
+
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw io_error("Failed to create", tmp_path);
+    }
+
+    ssize_t n = pwrite(fd, data, sizeof(data), 0);
+    if (n != static_cast<ssize_t>(sizeof(data)) || fdatasync(fd) != 0) {
+        close(fd);
+        throw io_error("Failed to write", tmp_path);
+    }
+    close(fd);
+
+    if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw io_error("Failed to rename", tmp_path);
+    }
+    if (!sync_dir()) {
+        throw io_error("Failed to sync", dir_);
+    }
+}
+
+bool file_log_store::sync_dir() const {
+    int fd = open(dir_.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+
+    int rc = fsync(fd);
+    close(fd);
+    return rc == 0;
+}
+
+ptr<file_log_store::segment> file_log_store::open_segment(uint64_t first_idx,
+                                                          uint64_t capacity) {
+    std::string path = segment_path(dir_, first_idx);
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw io_error("Failed to create log segment", path);
+    }
+
+    // Allocate the whole segment up front, so that appends never have to
+    // extend the file.
+    int rc = posix_fallocate(fd, 0, static_cast<off_t>(capacity));
+    if (rc != 0) {
+        close(fd);
+        errno = rc;
+        throw io_error("Failed to preallocate log segment", path);
+    }
+
+    dir_dirty_ = true;
+    return cs_new<segment>(path, first_idx, fd, capacity, 0);
+}
+
+void file_log_store::remove_segment(segment_map::iterator it) {
+    // Readers still holding the segment keep reading from the open file, and
+    // a new segment may reuse the name right away.
+    unlink(it->second->path_.c_str());
+    segments_.erase(it);
+    dir_dirty_ = true;
+}
+
+ptr<file_log_store::segment> file_log_store::segment_of(uint64_t index) const {
+    auto it = segments_.upper_bound(index);
+    return std::prev(it)->second;
+}
+
+uint64_t file_log_store::next_slot() const {
+    std::lock_guard<std::mutex> l(lock_);
+    return start_idx_ + index_.size();
+}
+
+uint64_t file_log_store::start_index() const { return start_idx_; }
+
+ptr<log_entry> file_log_store::last_entry() const {
+    uint64_t last_idx;
+    {
+        std::lock_guard<std::mutex> l(lock_);
+        if (index_.empty()) {
+            return cs_new<log_entry>(0, nullptr);
+        }
+
+        last_idx = start_idx_ + index_.size() - 1;
+    }
+
+    ptr<log_entry> entry = read_entry(last_idx);
+    return entry ? entry : cs_new<log_entry>(0, nullptr);
+}
+
+uint64_t file_log_store::append(ptr<log_entry>& entry) {
+    ptr<buffer> buf = entry->serialize();
+    uint32_t crc = crc32c(buf->data_begin(), buf->size());
+
+    uint64_t index;
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> l(lock_);
+        index = append_serialized(entry->get_term(), buf->data_begin(),
+                                  static_cast<uint32_t>(buf->size()), crc);
+        ticket = syncer_.written(buf->size(), index);
+    }
+
+    sync_append(ticket);
+    return index;
+}
+
+uint64_t file_log_store::append_serialized(uint64_t term,
+                                           const nuraft::byte* data,
+                                           uint32_t size, uint32_t crc) {
+    uint64_t index = start_idx_ + index_.size();
+    uint64_t record_size = RECORD_HEADER_SIZE + size;
+
+    ptr<segment> seg = segments_.empty() ? nullptr : segments_.rbegin()->second;
+    if (!seg || seg->end_ + record_size + sizeof(END_OF_SEGMENT) >
+                    seg->capacity_) {
+        seg = open_segment(
+            index, std::max(segment_size_,
+                            record_size + sizeof(END_OF_SEGMENT)));
+        segments_.emplace(index, seg);
+    }
+
+    uint8_t header[RECORD_HEADER_SIZE];
+    memcpy(header, &size, sizeof(size));
+    memcpy(header + sizeof(size), &crc, sizeof(crc));
+    memcpy(header + sizeof(size) + sizeof(crc), &term, sizeof(term));
+
+    uint32_t end_marker = END_OF_SEGMENT;
+    struct iovec iov[3];
+    iov[0].iov_base = header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = const_cast<nuraft::byte*>(data);
+    iov[1].iov_len = size;
+    iov[2].iov_base = &end_marker;
+    iov[2].iov_len = sizeof(end_marker);
+
+    ssize_t expected = static_cast<ssize_t>(record_size + sizeof(end_marker));
+    ssize_t n = pwritev(seg->fd_, iov, 3, static_cast<off_t>(seg->end_));
+    if (n != expected) {
+        throw io_error("Failed to append to log segment", seg->path_);
+    }
+
+    index_.push_back(
+        entry_location{seg->end_ + RECORD_HEADER_SIZE, size, crc, term});
+    seg->end_ += record_size;
+    seg->dirty_ = true;
+
+    return index;
+}
+
+void file_log_store::truncate_from(uint64_t index) {
+    uint64_t next = start_idx_ + index_.size();
+    if (index >= next) {
+        return;
+    }
+
+    // Find where the entry lives before any segment goes away. If it opens
+    // its segment, the segment goes away whole and the one before it already
+    // ends right after the last entry kept.
+    ptr<segment> seg;
+    uint64_t new_end = 0;
+    if (index >= start_idx_ && !segments_.empty()) {
+        seg = segment_of(index);
+        new_end = index_[index - start_idx_].offset_ - RECORD_HEADER_SIZE;
+        if (seg->first_idx_ >= index) {
+            seg = nullptr;
+        }
+    }
+
+    // Whole segments past the truncation point go away at once.
+    while (!segments_.empty() && segments_.rbegin()->first >= index) {
+        remove_segment(std::prev(segments_.end()));
+    }
+
+    if (seg && new_end < seg->end_) {
+        uint32_t end_marker = END_OF_SEGMENT;
+        ssize_t n = pwrite(seg->fd_, &end_marker, sizeof(end_marker),
+                           static_cast<off_t>(new_end));
+        if (n != static_cast<ssize_t>(sizeof(end_marker))) {
+            throw io_error("Failed to truncate log segment", seg->path_);
+        }
+
+        seg->end_ = new_end;
+        seg->dirty_ = true;
+    }
+
+    index_.resize(index > start_idx_ ? index - start_idx_ : 0);
+}
+
+void file_log_store::write_at(uint64_t index, ptr<log_entry>& entry) {
+    ptr<buffer> buf = entry->serialize();
+    uint32_t crc = crc32c(buf->data_begin(), buf->size());
+
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> l(lock_);
+        truncate_from(index);
+        append_serialized(entry->get_term(), buf->data_begin(),
+                          static_cast<uint32_t>(buf->size()), crc);
+        ticket = syncer_.written(buf->size(), index, index);
+    }
+
+    sync_append(ticket);
+}
+
+ptr<std::vector<ptr<log_entry>>> file_log_store::log_entries(uint64_t start,
+                                                             uint64_t end) {
+    ptr<std::vector<ptr<log_entry>>> ret =
+        cs_new<std::vector<ptr<log_entry>>>();
+    ret->reserve(end - start);
+
+    for (uint64_t i = start; i < end; ++i) {
+        ptr<log_entry> entry = read_entry(i);
+        if (!entry) {
+            return nullptr;
+        }
+
+        ret->push_back(entry);
+    }
+
+    return ret;
+}
+
+ptr<log_entry> file_log_store::entry_at(uint64_t index) {
+    return read_entry(index);
+}
+
+ptr<log_entry> file_log_store::read_entry(uint64_t index) const {
+    ptr<segment> seg;
+    entry_location loc;
+    {
+        std::lock_guard<std::mutex> l(lock_);
+        if (index < start_idx_ || index >= start_idx_ + index_.size()) {
+            return nullptr;
+        }
+
+        seg = segment_of(index);
+        loc = index_[index - start_idx_];
+    }
+
+    // `seg` keeps the file open even if the entry is truncated or compacted
+    // away in the meantime.
+    ptr<buffer> buf = buffer::alloc(loc.size_);
+    pread_fully(seg->fd_, buf->data_begin(), loc.size_, loc.offset_,
+                seg->path_);
+    if (crc32c(buf->data_begin(), loc.size_) != loc.crc_) {
+        throw std::runtime_error("Corrupted log entry " +
+                                 std::to_string(index) + " in " + seg->path_);
+    }
+
+    return log_entry::deserialize(*buf);
+}
+
+uint64_t file_log_store::term_at(uint64_t index) {
+    std::lock_guard<std::mutex> l(lock_);
+    if (index >= start_idx_ + index_.size()) {
+        throw std::runtime_error("Log index out of range");
+    } else if (index < start_idx_) {
+        return 0;
+    }
+
+    return index_[index - start_idx_].term_;
+}
+
+ptr<buffer> file_log_store::pack(uint64_t index, int32_t signed_cnt) {
+    std::vector<std::pair<ptr<segment>, entry_location>> entries;
+    size_t size_total = 0;
+    {
+        std::lock_guard<std::mutex> l(lock_);
+        uint64_t next = start_idx_ + index_.size();
+        uint64_t end = std::min(index + static_cast<uint64_t>(signed_cnt), next);
+
+        for (uint64_t i = std::max<uint64_t>(index, start_idx_); i < end; ++i) {
+            entries.emplace_back(segment_of(i), index_[i - start_idx_]);
+            size_total += entries.back().second.size_;
+        }
+    }
+
+    ptr<buffer> ret = log_pack_create(entries.size(), size_total);
+
+    // Copy the serialized entries straight from their segments, checking
+    // them before they are sent anywhere.
+    for (const auto& [seg, loc] : entries) {
+        nuraft::byte* data = log_pack_reserve(*ret, loc.size_, loc.crc_);
+        pread_fully(seg->fd_, data, loc.size_, loc.offset_, seg->path_);
+        if (crc32c(data, loc.size_) != loc.crc_) {
+            throw std::runtime_error("Corrupted log entry in " + seg->path_);
+        }
+    }
+
+    ret->pos(0);
+    return ret;
+}
+
+void file_log_store::apply_pack(uint64_t index, buffer& pack) {
+    pack.pos(0);
+    int32_t signed_cnt = pack.get_int();
+    if (signed_cnt <= 0) {
+        throw std::runtime_error("Invalid log entry count");
+    }
+
+    // Check the whole pack before touching the log, so that a corrupted
+    // pack leaves it as it was.
+    std::vector<std::pair<const nuraft::byte*, entry_location>> entries;
+    entries.reserve(static_cast<size_t>(signed_cnt));
+    size_t bytes = 0;
+    for (int32_t i = 0; i < signed_cnt; ++i) {
+        entry_location loc{};
+        const nuraft::byte* data = log_pack_get(pack, loc.size_);
+        loc.crc_ = get_log_checksum(data - LOG_CHECKSUM_SIZE);
+        loc.term_ = get_log_term(data, loc.size_);
+
+        entries.emplace_back(data, loc);
+        bytes += loc.size_;
+    }
+
+    std::unique_lock<std::mutex> l(lock_);
+    if (index < start_idx_ || index > start_idx_ + index_.size()) {
+        // The pack does not line up with what we have; start over from it.
+        write_start_index(index);
+        while (!segments_.empty()) {
+            remove_segment(segments_.begin());
+        }
+        index_.clear();
+        start_idx_ = index;
+    } else {
+        truncate_from(index);
+    }
+
+    for (const auto& [data, loc] : entries) {
+        append_serialized(loc.term_, data, loc.size_, loc.crc_);
+    }
+
+    uint64_t ticket = syncer_.written(
+        bytes, index + static_cast<uint64_t>(signed_cnt) - 1, index);
+    l.unlock();
+    sync_append(ticket);
+}
+
+bool file_log_store::compact(uint64_t last_log_index) {
+    std::lock_guard<std::mutex> l(lock_);
+    if (last_log_index < start_idx_) {
+        return true;
+    }
+
+    // Recorded before any segment goes away, so that a restart never brings
+    // back what was compacted.
+    write_start_index(last_log_index + 1);
+
+    uint64_t next = start_idx_ + index_.size();
+    if (last_log_index + 1 >= next) {
+        while (!segments_.empty()) {
+            remove_segment(segments_.begin());
+        }
+        index_.clear();
+    } else {
+        index_.erase(index_.begin(),
+                     index_.begin() +
+                         static_cast<std::ptrdiff_t>(last_log_index + 1 -
+                                                     start_idx_));
+
+        // Drop every segment whose entries have all been compacted away.
+        while (segments_.size() > 1 &&
+               std::next(segments_.begin())->first <= last_log_index + 1) {
+            remove_segment(segments_.begin());
+        }
+    }
+
+    start_idx_ = last_log_index + 1;
+    syncer_.compacted(last_log_index);
+    return true;
+}
+
+bool file_log_store::flush() { return syncer_.sync_all(); }
+
+uint64_t file_log_store::last_durable_index() {
+    return syncer_.durable_index();
+}
+
+void file_log_store::set_raft_server(nuraft::raft_server* raft) {
+    syncer_.set_durable_callback(
+        [raft] { raft->notify_log_append_completion(true); });
+}
+
+void file_log_store::detach_raft_server() {
+    syncer_.stop();
+    syncer_.set_durable_callback(nullptr);
+}
+
+bool file_log_store::sync_segments() {
+    std::vector<ptr<segment>> dirty;
+    bool dir_dirty;
+    {
+        std::lock_guard<std::mutex> l(lock_);
+        dir_dirty = dir_dirty_;
+        dir_dirty_ = false;
+        for (auto& [first_idx, seg] : segments_) {
+            if (seg->dirty_) {
+                seg->dirty_ = false;
+                dirty.push_back(seg);
+            }
+        }
+    }
+
+    // New segments only count once their names are durable, and removed
+    // ones must not come back.
+    bool ok = true;
+    if (dir_dirty && !sync_dir()) {
+        std::lock_guard<std::mutex> l(lock_);
+        dir_dirty_ = true;
+        ok = false;
+    }
+
+    for (const auto& seg : dirty) {
+        if (fdatasync(seg->fd_) != 0) {
+            // Try again on the next sync.
+            std::lock_guard<std::mutex> l(lock_);
+            seg->dirty_ = true;
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+void file_log_store::sync_append(uint64_t ticket) {
+    if (!syncer_.on_append(ticket)) {
+        throw std::runtime_error("Failed to sync log segments in " + dir_);
+    }
+}
+
+}  // namespace replicated_splinterdb
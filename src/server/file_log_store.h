@@ -0,0 +1,309 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#include "libnuraft/log_store.hxx"
+#include "libnuraft/nuraft.hxx"
+#include "log_syncer.h"
+
+namespace replicated_splinterdb {
+
+/**
+ * A Raft log store made of append-only segment files.
+ *
+ * Entries are appended back-to-back to the newest segment, which is
+ * preallocated when it is created, so appending is a sequential write. Once a
+ * segment is full, a new one is started. The location and term of every entry
+ * are kept in a dense in-memory index, so reading an entry takes a single
+ * `pread` and looking up a term takes no I/O at all.
+ *
+ * Truncation (`write_at`) and compaction drop whole segments wherever they
+ * can, and segments are recovered from disk when the store is opened. The
+ * start index left by the last compaction is kept in a file of its own,
+ * since the oldest segment may still hold entries before it.
+ *
+ * Appends are synced with `fdatasync` according to the `log_sync_options`,
+ * either before they return or in the background.
+ *
+ * Every record carries the CRC32C of its entry, which is checked whenever the
+ * entry is read or packed, and for the newest segment on recovery, where it
+ * tells a torn final record apart from a complete one.
+ */
+class file_log_store : public nuraft::log_store {
+  public:
+    // Default capacity of a single segment file.
+    static constexpr uint64_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+    file_log_store(const std::string& dir,
+                   uint64_t segment_size = DEFAULT_SEGMENT_SIZE,
+                   const log_sync_options& sync = log_sync_options());
+
+    ~file_log_store();
+
+    __nocopy__(file_log_store);
+
+  public:
+    /**
+     * The first available slot of the store, starts with 1
+     *
+     * @return Last log index number + 1
+     */
+    uint64_t next_slot() const override;
+
+    /**
+     * The start index of the log store, at the very beginning, it must be 1.
+     * However, after some compact actions, this could be anything equal to or
+     * greater than one
+     */
+    uint64_t start_index() const override;
+
+    /**
+     * The last log entry in store.
+     *
+     * @return If no log entry exists: a dummy constant entry with
+     *         value set to null and term set to zero.
+     */
+    nuraft::ptr<nuraft::log_entry> last_entry() const override;
+
+    /**
+     * Append a log entry to store.
+     *
+     * @param entry Log entry
+     * @return Log index number.
+     */
+    uint64_t append(nuraft::ptr<nuraft::log_entry>& entry) override;
+
+    /**
+     * Overwrite a log entry at the given `index`.
+     * This API should make sure that all log entries
+     * after the given `index` should be truncated (if exist),
+     * as a result of this function call.
+     *
+     * @param index Log index number to overwrite.
+     * @param entry New log entry to overwrite.
+     */
+    void write_at(uint64_t index,
+                  nuraft::ptr<nuraft::log_entry>& entry) override;
+
+    /**
+     * Get log entries with index [start, end).
+     *
+     * Return nullptr to indicate error if any log entry within the requested
+     * range could not be retrieved (e.g. due to external log truncation).
+     *
+     * @param start The start log index number (inclusive).
+     * @param end The end log index number (exclusive).
+     * @return The log entries between [start, end).
+     */
+    nuraft::ptr<std::vector<nuraft::ptr<nuraft::log_entry>>> log_entries(
+        uint64_t start, uint64_t end) override;
+
+    /**
+     * Get the log entry at the specified log index number.
+     *
+     * @param index Should be equal to or greater than 1.
+     * @return The log entry or null if index >= this->next_slot().
+     */
+    nuraft::ptr<nuraft::log_entry> entry_at(uint64_t index) override;
+
+    /**
+     * Get the term for the log entry at the specified index.
+     * Suggest to stop the system if the index >= this->next_slot()
+     *
+     * @param index Should be equal to or greater than 1.
+     * @return The term for the specified log entry, or
+     *         0 if index < this->start_index().
+     */
+    uint64_t term_at(uint64_t index) override;
+
+    /**
+     * Pack the given number of log items starting from the given index.
+     *
+     * @param index The start log index number (inclusive).
+     * @param cnt The number of logs to pack.
+     * @return Packed (encoded) logs.
+     */
+    nuraft::ptr<nuraft::buffer> pack(uint64_t index, int32_t cnt) override;
+
+    /**
+     * Apply the log pack to current log store, starting from index.
+     *
+     * @param index The start log index number (inclusive).
+     * @param Packed logs.
+     */
+    void apply_pack(uint64_t index, nuraft::buffer& pack) override;
+
+    /**
+     * Compact the log store by purging all log entries,
+     * including the given log index number.
+     *
+     * If current maximum log index is smaller than given `last_log_index`,
+     * set start log index to `last_log_index + 1`.
+     *
+     * @param last_log_index Log index number that will be purged up to
+     * (inclusive).
+     * @return `true` on success.
+     */
+    bool compact(uint64_t last_log_index) override;
+
+    /**
+     * Synchronously flush all log entries in this log store to the backing
+     * storage so that all log entries are guaranteed to be durable upon process
+     * crash.
+     *
+     * @return `true` on success.
+     */
+    bool flush() override;
+
+    /**
+     * The last log index known to be durable. Appends run ahead of it when
+     * the store syncs in the background.
+     */
+    uint64_t last_durable_index() override;
+
+    /**
+     * Tell `raft` whenever entries become durable in the background, as
+     * NuRaft's parallel log appending requires.
+     */
+    void set_raft_server(nuraft::raft_server* raft);
+
+    /**
+     * Stop syncing in the background and telling the Raft server about it,
+     * before the server goes away. Appends are only synced by `flush`
+     * afterwards.
+     */
+    void detach_raft_server();
+
+  private:
+    /**
+     * One segment file. The file is closed once nobody refers to the segment
+     * anymore.
+     */
+    struct segment {
+        segment(const std::string& path, uint64_t first_idx, int fd,
+                uint64_t capacity, uint64_t end);
+
+        ~segment();
+
+        const std::string path_;
+
+        // Log index of the first entry in this segment.
+        const uint64_t first_idx_;
+
+        const int fd_;
+
+        // Preallocated size of the file.
+        const uint64_t capacity_;
+
+        // Offset right past the last record.
+        uint64_t end_;
+
+        // Set once the segment has been written to since the last flush.
+        bool dirty_;
+    };
+
+    using segment_map = std::map<uint64_t, nuraft::ptr<segment>>;
+
+    /**
+     * Where a log entry lives on disk.
+     */
+    struct entry_location {
+        uint64_t offset_;
+        uint32_t size_;
+        uint32_t crc_;
+        uint64_t term_;
+    };
+
+    const std::string dir_;
+
+    const uint64_t segment_size_;
+
+    // Segments by the log index of their first entry.
+    segment_map segments_;
+
+    // `index_[i]` is the location of the entry at `start_idx_ + i`.
+    std::deque<entry_location> index_;
+
+    /**
+     * The index of the first log.
+     */
+    std::atomic<uint64_t> start_idx_;
+
+    // Set once segments have been created or removed since the last sync.
+    bool dir_dirty_;
+
+    // Protects `segments_`, `index_`, `dir_dirty_` and the segments' write
+    // offsets.
+    mutable std::mutex lock_;
+
+    // Declared last so that its background thread stops before the segments
+    // go away.
+    log_syncer syncer_;
+
+    /**
+     * Load the segments found in `dir_`.
+     */
+    void recover();
+
+    /**
+     * @return The start index recorded by the last compaction, or 0 if the
+     *         log was never compacted.
+     */
+    uint64_t read_start_index() const;
+
+    /**
+     * Durably record `start_idx` as the start index of the log.
+     */
+    void write_start_index(uint64_t start_idx);
+
+    /**
+     * `fsync` `dir_`, so that files created, renamed or removed in it stay
+     * that way.
+     *
+     * @return `false` on failure.
+     */
+    bool sync_dir() const;
+
+    nuraft::ptr<segment> open_segment(uint64_t first_idx, uint64_t capacity);
+
+    /**
+     * Delete a segment's file and forget about it. Caller must hold `lock_`.
+     */
+    void remove_segment(segment_map::iterator it);
+
+    /**
+     * Find the segment holding `index`, which must be in the store.
+     */
+    nuraft::ptr<segment> segment_of(uint64_t index) const;
+
+    /**
+     * Drop every entry from `index` on. Caller must hold `lock_`.
+     */
+    void truncate_from(uint64_t index);
+
+    /**
+     * Append an already serialized entry with its CRC32C. Caller must hold
+     * `lock_`.
+     */
+    uint64_t append_serialized(uint64_t term, const nuraft::byte* data,
+                               uint32_t size, uint32_t crc);
+
+    nuraft::ptr<nuraft::log_entry> read_entry(uint64_t index) const;
+
+    /**
+     * `fdatasync` every segment written to since it was last synced, and
+     * `fsync` the directory if segments came or went.
+     */
+    bool sync_segments();
+
+    /**
+     * Wait for the write behind `ticket` to be synced, if the durability mode
+     * asks for it. Must be called without holding `lock_`.
+     */
+    void sync_append(uint64_t ticket);
+};
+
+}  // namespace replicated_splinterdb
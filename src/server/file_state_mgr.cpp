@@ -0,0 +1,171 @@
+#include "file_state_mgr.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+
+namespace replicated_splinterdb {
+
+using nuraft::buffer;
+using nuraft::cluster_config;
+using nuraft::cs_new;
+using nuraft::ptr;
+using nuraft::srv_config;
+using nuraft::srv_state;
+
+static const std::string CONFIG_FILE = "cluster_config";
+static const std::string STATE_FILE = "srv_state";
+
+static std::runtime_error io_error(const std::string& what,
+                                   const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + strerror(errno));
+}
+
+file_state_mgr::file_state_mgr(int32_t srv_id,
+                               const std::string& raft_endpoint,
+                               const std::string& client_endpoint,
+                               const std::string& dir,
+                               ptr<nuraft::log_store> log_store)
+    : my_id_(srv_id),
+      dir_(dir),
+      cur_log_store_(log_store),
+      my_srv_config_(
+          cs_new<srv_config>(srv_id, 0, raft_endpoint, client_endpoint, false)),
+      saved_config_(nullptr),
+      saved_state_(nullptr),
+      lock_() {
+    std::filesystem::create_directories(dir_);
+
+    ptr<buffer> config = read_file(CONFIG_FILE);
+    if (config) {
+        saved_config_ = cluster_config::deserialize(*config);
+    } else {
+        // Initial cluster config: contains only one server (myself).
+        saved_config_ = cs_new<cluster_config>();
+        saved_config_->get_servers().push_back(my_srv_config_);
+    }
+
+    ptr<buffer> state = read_file(STATE_FILE);
+    if (state) {
+        saved_state_ = srv_state::deserialize(*state);
+    }
+}
+
+ptr<cluster_config> file_state_mgr::load_config() {
+    std::lock_guard<std::mutex> l(lock_);
+    return saved_config_;
+}
+
+void file_state_mgr::save_config(const cluster_config& config) {
+    ptr<buffer> buf = config.serialize();
+    write_file(CONFIG_FILE, *buf);
+
+    std::lock_guard<std::mutex> l(lock_);
+    saved_config_ = cluster_config::deserialize(*buf);
+}
+
+void file_state_mgr::save_state(const srv_state& state) {
+    ptr<buffer> buf = state.serialize();
+    write_file(STATE_FILE, *buf);
+
+    std::lock_guard<std::mutex> l(lock_);
+    saved_state_ = srv_state::deserialize(*buf);
+}
+
+ptr<srv_state> file_state_mgr::read_state() {
+    std::lock_guard<std::mutex> l(lock_);
+    return saved_state_;
+}
+
+ptr<nuraft::log_store> file_state_mgr::load_log_store() {
+    return cur_log_store_;
+}
+
+int32_t file_state_mgr::server_id() { return my_id_; }
+
+void file_state_mgr::system_exit(const int exit_code) {}
+
+ptr<srv_config> file_state_mgr::get_srv_config() const {
+    return my_srv_config_;
+}
+
+void file_state_mgr::write_file(const std::string& name, const buffer& data) {
+    std::string path = dir_ + "/" + name;
+    std::string tmp_path = path + ".tmp";
+
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw io_error("Failed to create", tmp_path);
+    }
+
+    const nuraft::byte* bytes = data.data_begin();
+    size_t remaining = data.size();
+    while (remaining > 0) {
+        ssize_t n = write(fd, bytes, remaining);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            close(fd);
+            throw io_error("Failed to write", tmp_path);
+        }
+
+        bytes += n;
+        remaining -= static_cast<size_t>(n);
+    }
+
+    if (fsync(fd) != 0) {
+        close(fd);
+        throw io_error("Failed to sync", tmp_path);
+    }
+    close(fd);
+
+    if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw io_error("Failed to rename", tmp_path);
+    }
+
+    // Make the rename itself durable.
+    int dir_fd = open(dir_.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+}
+
+ptr<buffer> file_state_mgr::read_file(const std::string& name) {
+    std::string path = dir_ + "/" + name;
+
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec || size == 0) {
+        return nullptr;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw io_error("Failed to open", path);
+    }
+
+    ptr<buffer> buf = buffer::alloc(static_cast<size_t>(size));
+    nuraft::byte* bytes = buf->data_begin();
+    size_t remaining = static_cast<size_t>(size);
+    while (remaining > 0) {
+        ssize_t n = read(fd, bytes, remaining);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            close(fd);
+            throw io_error("Failed to read", path);
+        }
+
+        bytes += n;
+        remaining -= static_cast<size_t>(n);
+    }
+    close(fd);
+
+    buf->pos(0);
+    return buf;
+}
+
+}  // namespace replicated_splinterdb
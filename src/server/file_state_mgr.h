@@ -0,0 +1,71 @@
+#pragma once
+
+#include <mutex>
+
+#include "libnuraft/nuraft.hxx"
+
+namespace replicated_splinterdb {
+
+/**
+ * A Raft state manager that keeps the cluster config and the server state
+ * (term and vote) in files under a directory, so that a restarted server
+ * rejoins the cluster with what it had instead of as a blank member.
+ *
+ * Both are saved by writing a temporary file, syncing it and renaming it over
+ * the old one, so a crash leaves either the old or the new version behind.
+ */
+class file_state_mgr : public nuraft::state_mgr {
+  public:
+    file_state_mgr(int32_t srv_id, const std::string& raft_endpoint,
+                   const std::string& client_endpoint, const std::string& dir,
+                   nuraft::ptr<nuraft::log_store> log_store);
+
+    ~file_state_mgr() {}
+
+    __nocopy__(file_state_mgr);
+
+    nuraft::ptr<nuraft::cluster_config> load_config() override;
+
+    void save_config(const nuraft::cluster_config& config) override;
+
+    void save_state(const nuraft::srv_state& state) override;
+
+    nuraft::ptr<nuraft::srv_state> read_state() override;
+
+    nuraft::ptr<nuraft::log_store> load_log_store() override;
+
+    int32_t server_id() override;
+
+    void system_exit(const int exit_code) override;
+
+    nuraft::ptr<nuraft::srv_config> get_srv_config() const;
+
+  private:
+    const int32_t my_id_;
+
+    const std::string dir_;
+
+    nuraft::ptr<nuraft::log_store> cur_log_store_;
+
+    nuraft::ptr<nuraft::srv_config> my_srv_config_;
+
+    nuraft::ptr<nuraft::cluster_config> saved_config_;
+
+    nuraft::ptr<nuraft::srv_state> saved_state_;
+
+    // Protects `saved_config_` and `saved_state_`.
+    std::mutex lock_;
+
+    /**
+     * Atomically replace the file `name` in `dir_` with `data`.
+     */
+    void write_file(const std::string& name, const nuraft::buffer& data);
+
+    /**
+     * @return The contents of the file `name` in `dir_`, or null if there is
+     *         no such file.
+     */
+    nuraft::ptr<nuraft::buffer> read_file(const std::string& name);
+};
+
+}  // namespace replicated_splinterdb
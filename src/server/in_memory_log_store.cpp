@@ -17,23 +17,29 @@ limitations under the License.
 
 #include "in_memory_log_store.h"
 
-#include <cassert>
+#include <algorithm>
+#include <stdexcept>
 
+#include "common/crc32c.h"
 #include "libnuraft/nuraft.hxx"
+#include "log_pack.h"
 
 namespace nuraft {
 
+inmem_log_store::ring::ring(size_t capacity)
+    : capacity_(capacity), slots_(new slot[capacity]) {}
+
 inmem_log_store::inmem_log_store()
-    : start_idx_(1),
+    : ring_(cs_new<ring>(INITIAL_CAPACITY)),
+      start_idx_(1),
+      next_idx_(1),
+      write_lock_(),
+      dummy_entry_(cs_new<log_entry>(0, buffer::alloc(sz_ulong))),
       raft_server_bwd_pointer_(nullptr),
       disk_emul_delay(0),
       disk_emul_thread_(nullptr),
       disk_emul_thread_stop_signal_(false),
-      disk_emul_last_durable_index_(0) {
-    // Dummy entry for index 0.
-    ptr<buffer> buf = buffer::alloc(sz_ulong);
-    logs_[0] = cs_new<log_entry>(0, buf);
-}
+      disk_emul_last_durable_index_(0) {}
 
 inmem_log_store::~inmem_log_store() {
     if (disk_emul_thread_) {
@@ -45,79 +51,95 @@ inmem_log_store::~inmem_log_store() {
     }
 }
 
-ptr<log_entry> inmem_log_store::make_clone(const ptr<log_entry>& entry) {
-    // NOTE:
-    //   Timestamp is used only when `replicate_log_timestamp_` option is on.
-    //   Otherwise, log store does not need to store or load it.
-    ptr<log_entry> clone =
-        cs_new<log_entry>(entry->get_term(), buffer::clone(entry->get_buf()),
-                          entry->get_val_type(), entry->get_timestamp(),
-                          entry->has_crc32(), entry->get_crc32(), false);
-    return clone;
-}
+ptr<log_entry> inmem_log_store::read_entry(ulong index) const {
+    if (index < start_idx_ || index >= next_idx_) {
+        return nullptr;
+    }
 
-ulong inmem_log_store::next_slot() const {
-    std::lock_guard<std::mutex> l(logs_lock_);
-    // Exclude the dummy entry.
-    return start_idx_ + logs_.size() - 1;
+    ptr<ring> r = std::atomic_load(&ring_);
+    ptr<log_entry> entry = std::atomic_load(&r->at(index).entry_);
+
+    // The slot is only reused once the log has been compacted past `index`.
+    return index >= start_idx_ ? entry : nullptr;
 }
 
-ulong inmem_log_store::start_index() const { return start_idx_; }
+void inmem_log_store::store_entry(ptr<log_entry> entry) {
+    ulong start = start_idx_;
+    ulong index = next_idx_;
+    ptr<ring> r = std::atomic_load(&ring_);
 
-ptr<log_entry> inmem_log_store::last_entry() const {
-    ulong next_idx = next_slot();
-    std::lock_guard<std::mutex> l(logs_lock_);
-    auto entry = logs_.find(next_idx - 1);
-    if (entry == logs_.end()) {
-        entry = logs_.find(0);
+    if (index - start >= r->capacity_) {
+        ptr<ring> bigger = cs_new<ring>(r->capacity_ * 2);
+        for (ulong ii = start; ii < index; ++ii) {
+            bigger->at(ii).term_.store(r->at(ii).term_);
+            bigger->at(ii).entry_ = std::atomic_load(&r->at(ii).entry_);
+        }
+        std::atomic_store(&ring_, bigger);
+        r = bigger;
     }
 
-    return make_clone(entry->second);
+    slot& s = r->at(index);
+    s.term_.store(entry->get_term());
+    std::atomic_store(&s.entry_, std::move(entry));
 }
 
-ulong inmem_log_store::append(ptr<log_entry>& entry) {
-    ptr<log_entry> clone = make_clone(entry);
+void inmem_log_store::emulate_write(ulong index) {
+    if (!disk_emul_delay) {
+        return;
+    }
 
-    std::lock_guard<std::mutex> l(logs_lock_);
-    size_t idx = start_idx_ + logs_.size() - 1;
-    logs_[idx] = clone;
+    std::lock_guard<std::mutex> l(disk_emul_lock_);
+    uint64_t cur_time = timer_helper::get_timeofday_us();
+    disk_emul_logs_being_written_[cur_time + disk_emul_delay * 1000] = index;
 
-    if (disk_emul_delay) {
-        uint64_t cur_time = timer_helper::get_timeofday_us();
-        disk_emul_logs_being_written_[cur_time + disk_emul_delay * 1000] = idx;
-        disk_emul_ea_.invoke();
+    // Remove entries greater than `index`, in case it was overwritten.
+    auto entry = disk_emul_logs_being_written_.begin();
+    while (entry != disk_emul_logs_being_written_.end()) {
+        if (entry->second > index) {
+            entry = disk_emul_logs_being_written_.erase(entry);
+        } else {
+            entry++;
+        }
     }
-
-    return idx;
+    disk_emul_ea_.invoke();
 }
 
-void inmem_log_store::write_at(ulong index, ptr<log_entry>& new_entry) {
-    ptr<log_entry> clone = make_clone(new_entry);
+ulong inmem_log_store::next_slot() const { return next_idx_; }
 
-    // Discard all logs equal to or greater than `index.
-    std::lock_guard<std::mutex> l(logs_lock_);
-    auto itr = logs_.lower_bound(index);
-    while (itr != logs_.end()) {
-        itr = logs_.erase(itr);
+ulong inmem_log_store::start_index() const { return start_idx_; }
+
+ptr<log_entry> inmem_log_store::last_entry() const {
+    ptr<log_entry> entry = read_entry(next_idx_ - 1);
+    return entry ? entry : dummy_entry_;
+}
+
+ulong inmem_log_store::append(ptr<log_entry>& entry) {
+    ulong idx;
+    {
+        std::lock_guard<std::mutex> l(write_lock_);
+        idx = next_idx_;
+        store_entry(entry);
+        next_idx_ = idx + 1;
     }
-    logs_[index] = clone;
 
-    if (disk_emul_delay) {
-        uint64_t cur_time = timer_helper::get_timeofday_us();
-        disk_emul_logs_being_written_[cur_time + disk_emul_delay * 1000] =
-            index;
-
-        // Remove entries greater than `index`.
-        auto entry = disk_emul_logs_being_written_.begin();
-        while (entry != disk_emul_logs_being_written_.end()) {
-            if (entry->second > index) {
-                entry = disk_emul_logs_being_written_.erase(entry);
-            } else {
-                entry++;
-            }
+    emulate_write(idx);
+    return idx;
+}
+
+void inmem_log_store::write_at(ulong index, ptr<log_entry>& new_entry) {
+    {
+        // Discard all logs equal to or greater than `index`. The slots past
+        // it are overwritten as the log grows again.
+        std::lock_guard<std::mutex> l(write_lock_);
+        if (index < start_idx_ || index > next_idx_) {
+            throw std::runtime_error("Log index out of range");
         }
-        disk_emul_ea_.invoke();
+        next_idx_ = index;
+        store_entry(new_entry);
+        next_idx_ = next_idx_ + 1;
     }
+
+    emulate_write(index);
 }
 
 ptr<std::vector<ptr<log_entry>>> inmem_log_store::log_entries(ulong start,
@@ -125,20 +147,13 @@ ptr<std::vector<ptr<log_entry>>> inmem_log_store::log_entries(ulong start,
     ptr<std::vector<ptr<log_entry>>> ret =
         cs_new<std::vector<ptr<log_entry>>>();
 
-    ret->resize(end - start);
-    ulong cc = 0;
+    ret->reserve(end > start ? end - start : 0);
     for (ulong ii = start; ii < end; ++ii) {
-        ptr<log_entry> src = nullptr;
-        {
-            std::lock_guard<std::mutex> l(logs_lock_);
-            auto entry = logs_.find(ii);
-            if (entry == logs_.end()) {
-                entry = logs_.find(0);
-                assert(0);
-            }
-            src = entry->second;
+        ptr<log_entry> entry = read_entry(ii);
+        if (!entry) {
+            return nullptr;
         }
-        (*ret)[cc++] = make_clone(src);
+        ret->push_back(entry);
     }
     return ret;
 }
@@ -154,18 +169,12 @@ ptr<std::vector<ptr<log_entry>>> inmem_log_store::log_entries_ext(
 
     size_t accum_size = 0;
     for (ulong ii = start; ii < end; ++ii) {
-        ptr<log_entry> src = nullptr;
-        {
-            std::lock_guard<std::mutex> l(logs_lock_);
-            auto entry = logs_.find(ii);
-            if (entry == logs_.end()) {
-                entry = logs_.find(0);
-                assert(0);
-            }
-            src = entry->second;
+        ptr<log_entry> entry = read_entry(ii);
+        if (!entry) {
+            return nullptr;
         }
-        ret->push_back(make_clone(src));
-        accum_size += src->get_buf().size();
+        ret->push_back(entry);
+        accum_size += entry->get_buf().size();
         if (batch_size_hint_in_bytes &&
             accum_size >= (ulong)batch_size_hint_in_bytes)
             break;
@@ -174,29 +183,18 @@ ptr<std::vector<ptr<log_entry>>> inmem_log_store::log_entries_ext(
 }
 
 ptr<log_entry> inmem_log_store::entry_at(ulong index) {
-    ptr<log_entry> src = nullptr;
-    {
-        std::lock_guard<std::mutex> l(logs_lock_);
-        auto entry = logs_.find(index);
-        if (entry == logs_.end()) {
-            entry = logs_.find(0);
-        }
-        src = entry->second;
-    }
-    return make_clone(src);
+    ptr<log_entry> entry = read_entry(index);
+    return entry ? entry : dummy_entry_;
 }
 
 ulong inmem_log_store::term_at(ulong index) {
-    ulong term = 0;
-    {
-        std::lock_guard<std::mutex> l(logs_lock_);
-        auto entry = logs_.find(index);
-        if (entry == logs_.end()) {
-            entry = logs_.find(0);
-        }
-        term = entry->second->get_term();
+    if (index < start_idx_ || index >= next_idx_) {
+        return 0;
     }
-    return term;
+
+    ptr<ring> r = std::atomic_load(&ring_);
+    ulong term = r->at(index).term_.load();
+    return index >= start_idx_ ? term : 0;
 }
 
 ptr<buffer> inmem_log_store::pack(ulong index, int32 cnt) {
@@ -204,26 +202,23 @@ ptr<buffer> inmem_log_store::pack(ulong index, int32 cnt) {
 
     size_t size_total = 0;
     for (ulong ii = index; ii < index + cnt; ++ii) {
-        ptr<log_entry> le = nullptr;
-        {
-            std::lock_guard<std::mutex> l(logs_lock_);
-            le = logs_[ii];
+        ptr<log_entry> le = read_entry(ii);
+        if (!le) {
+            throw std::runtime_error("Log index out of range");
         }
-        assert(le.get());
         ptr<buffer> buf = le->serialize();
         size_total += buf->size();
         logs.push_back(buf);
     }
 
+    // Packs are in the format shared by all log stores (see `log_pack.h`).
     ptr<buffer> buf_out =
-        buffer::alloc(sizeof(int32) + cnt * sizeof(int32) + size_total);
-    buf_out->pos(0);
-    buf_out->put((int32)cnt);
-
-    for (auto& entry : logs) {
-        ptr<buffer>& bb = entry;
-        buf_out->put((int32)bb->size());
-        buf_out->put(*bb);
+        replicated_splinterdb::log_pack_create(logs.size(), size_total);
+    for (auto& bb : logs) {
+        uint32_t size = static_cast<uint32_t>(bb->size());
+        replicated_splinterdb::log_pack_put(
+            *buf_out, bb->data_begin(), size,
+            replicated_splinterdb::crc32c(bb->data_begin(), size));
     }
     return buf_out;
 }
@@ -232,45 +227,66 @@ void inmem_log_store::apply_pack(ulong index, buffer& pack) {
     pack.pos(0);
     int32 num_logs = pack.get_int();
 
+    // Check every entry before storing any of them.
+    std::vector<ptr<log_entry>> entries;
     for (int32 ii = 0; ii < num_logs; ++ii) {
-        ulong cur_idx = index + ii;
-        int32 buf_size = pack.get_int();
+        uint32_t size;
+        const byte* data = replicated_splinterdb::log_pack_get(pack, size);
 
-        ptr<buffer> buf_local = buffer::alloc(buf_size);
-        pack.get(buf_local);
+        ptr<buffer> buf_local = buffer::alloc(size);
+        buf_local->put_raw(data, size);
+        buf_local->pos(0);
+        entries.push_back(log_entry::deserialize(*buf_local));
+    }
 
-        ptr<log_entry> le = log_entry::deserialize(*buf_local);
-        {
-            std::lock_guard<std::mutex> l(logs_lock_);
-            logs_[cur_idx] = le;
+    std::lock_guard<std::mutex> l(write_lock_);
+    ulong start = start_idx_;
+    if (index < start) {
+        // Readers only notice the start moving forward, so it never moves
+        // back.
+        throw std::runtime_error("Log pack starts before the log");
+    } else if (index > next_idx_) {
+        // The pack does not line up with what we have; start over from it,
+        // the way `compact` does: the start moves first, so that readers
+        // stay off the slots being reused.
+        ulong next = next_idx_;
+        start_idx_ = index;
+        next_idx_ = index;
+
+        ptr<ring> r = std::atomic_load(&ring_);
+        ulong end = std::min<ulong>(next, start + r->capacity_);
+        for (ulong ii = start; ii < end; ++ii) {
+            std::atomic_store(&r->at(ii).entry_, ptr<log_entry>());
         }
     }
+    next_idx_ = index;
 
-    {
-        std::lock_guard<std::mutex> l(logs_lock_);
-        auto entry = logs_.upper_bound(0);
-        if (entry != logs_.end()) {
-            start_idx_ = entry->first;
-        } else {
-            start_idx_ = 1;
-        }
+    for (auto& entry : entries) {
+        store_entry(entry);
+        next_idx_ = next_idx_ + 1;
     }
 }
 
 bool inmem_log_store::compact(ulong last_log_index) {
-    std::lock_guard<std::mutex> l(logs_lock_);
-    for (ulong ii = start_idx_; ii <= last_log_index; ++ii) {
-        auto entry = logs_.find(ii);
-        if (entry != logs_.end()) {
-            logs_.erase(entry);
-        }
+    std::lock_guard<std::mutex> l(write_lock_);
+    ulong start = start_idx_;
+    if (last_log_index < start) {
+        return true;
     }
 
     // WARNING:
     //   Even though nothing has been erased,
     //   we should set `start_idx_` to new index.
-    if (start_idx_ <= last_log_index) {
-        start_idx_ = last_log_index + 1;
+    start_idx_ = last_log_index + 1;
+    if (next_idx_ < start_idx_) {
+        next_idx_ = start_idx_.load();
+    }
+
+    // Let go of the compacted entries.
+    ptr<ring> r = std::atomic_load(&ring_);
+    ulong end = std::min<ulong>(last_log_index + 1, start + r->capacity_);
+    for (ulong ii = start; ii < end; ++ii) {
+        std::atomic_store(&r->at(ii).entry_, ptr<log_entry>());
     }
     return true;
 }
@@ -315,7 +331,7 @@ void inmem_log_store::disk_emul_loop() {
 
         bool call_notification = false;
         {
-            std::lock_guard<std::mutex> l(logs_lock_);
+            std::lock_guard<std::mutex> l(disk_emul_lock_);
             // Remove all timestamps equal to or smaller than `cur_time`,
             // and pick the greatest one among them.
             auto entry = disk_emul_logs_being_written_.begin();
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
 
 #include "libnuraft/event_awaiter.hxx"
@@ -29,6 +30,14 @@ namespace nuraft {
 
 class raft_server;
 
+/**
+ * A log store that keeps entries in memory only.
+ *
+ * Entries live in a ring indexed by log index, and the log bounds in atomics,
+ * so reads (`entry_at`, `term_at`, `log_entries`, ...) never take a lock:
+ * only writers are serialized with each other. Stored entries are shared with
+ * the caller rather than copied, and must not be modified once appended.
+ */
 class inmem_log_store : public log_store {
   public:
     inmem_log_store();
@@ -72,25 +81,83 @@ class inmem_log_store : public log_store {
     void set_disk_delay(raft_server* raft, size_t delay_ms);
 
   private:
-    static ptr<log_entry> make_clone(const ptr<log_entry>& entry);
+    // Number of slots the ring starts with; it doubles whenever it is full.
+    static constexpr size_t INITIAL_CAPACITY = 1024;
 
-    void disk_emul_loop();
+    /**
+     * One position of the ring. The term is kept next to the entry so that
+     * `term_at` needs neither a lock nor a reference count.
+     */
+    struct slot {
+        std::atomic<ulong> term_{0};
+
+        // Only accessed with `std::atomic_load` and `std::atomic_store`.
+        ptr<log_entry> entry_;
+    };
+
+    /**
+     * The entry at log index `i` lives in slot `i % capacity_`. A ring is
+     * replaced by a larger copy rather than resized, so readers holding the
+     * old one can finish with it.
+     */
+    struct ring {
+        explicit ring(size_t capacity);
+
+        slot& at(ulong index) { return slots_[index & (capacity_ - 1)]; }
+
+        // Always a power of two.
+        const size_t capacity_;
+
+        std::unique_ptr<slot[]> slots_;
+    };
+
+    /**
+     * Read the entry at `index` without locking.
+     *
+     * @return The entry, or null if `index` is not in the log.
+     */
+    ptr<log_entry> read_entry(ulong index) const;
+
+    /**
+     * Store `entry` at `next_idx_`, growing the ring if it is full. Caller
+     * must hold `write_lock_`, and publish the new end of the log.
+     */
+    void store_entry(ptr<log_entry> entry);
 
     /**
-     * Map of <log index, log data>.
+     * Note that `index` has been written, for the disk delay emulation.
      */
-    std::map<ulong, ptr<log_entry>> logs_;
+    void emulate_write(ulong index);
+
+    void disk_emul_loop();
 
     /**
-     * Lock for `logs_`.
+     * The entries, only accessed with `std::atomic_load` and
+     * `std::atomic_store`.
      */
-    mutable std::mutex logs_lock_;
+    ptr<ring> ring_;
 
     /**
      * The index of the first log.
      */
     std::atomic<ulong> start_idx_;
 
+    /**
+     * The index right past the last log.
+     */
+    std::atomic<ulong> next_idx_;
+
+    /**
+     * Serializes writers. Readers rely on writers publishing `start_idx_`
+     * before slots are reused, and entries before `next_idx_` covers them.
+     */
+    std::mutex write_lock_;
+
+    /**
+     * Returned in place of entries that are not in the log.
+     */
+    ptr<log_entry> dummy_entry_;
+
     /**
      * Backward pointer to Raft server.
      */
@@ -103,6 +170,11 @@ class inmem_log_store : public log_store {
      */
     std::atomic<size_t> disk_emul_delay;
 
+    /**
+     * Lock for `disk_emul_logs_being_written_`.
+     */
+    std::mutex disk_emul_lock_;
+
     /**
      * Map of <timestamp, log index>, emulating logs that is being written to
      * disk. Log index will be regarded as "durable" after the corresponding
@@ -17,16 +17,6 @@ limitations under the License.
 
 #pragma once
 
-#define _USE_SPLINTERDB_LOG_STORE 0
-
-#if _USE_SPLINTERDB_LOG_STORE
-#include "splinterdb_log_store.h"
-#define log_store_impl replicated_splinterdb::splinterdb_log_store
-#else
-#include "in_memory_log_store.h"
-#define log_store_impl inmem_log_store
-#endif
-
 #include "libnuraft/nuraft.hxx"
 
 namespace nuraft {
@@ -35,14 +25,11 @@ class inmem_state_mgr: public state_mgr {
 public:
     inmem_state_mgr(int srv_id,
                     const std::string& raft_endpoint,
-                    const std::string& client_endpoint)
+                    const std::string& client_endpoint,
+                    ptr<log_store> log_store)
         : my_id_(srv_id)
         , my_endpoint_(raft_endpoint)
-#if _USE_SPLINTERDB_LOG_STORE
-        , cur_log_store_( cs_new<log_store_impl>("log" + std::to_string(srv_id) + ".db") )
-#else
-        , cur_log_store_( cs_new<inmem_log_store>() )
-#endif
+        , cur_log_store_(log_store)
     {
         my_srv_config_ = cs_new<srv_config>( srv_id, 0, raft_endpoint, client_endpoint, false );
 
@@ -92,14 +79,10 @@ public:
 
     ptr<srv_config> get_srv_config() const { return my_srv_config_; }
 
-#if _USE_SPLINTERDB_LOG_STORE
-    splinterdb* get_splinterdb_handle() { return cur_log_store_->get_splinterdb_handle(); }
-#endif
-
 private:
     int my_id_;
     std::string my_endpoint_;
-    ptr<log_store_impl> cur_log_store_;
+    ptr<log_store> cur_log_store_;
     ptr<srv_config> my_srv_config_;
     ptr<cluster_config> saved_config_;
     ptr<srv_state> saved_state_;
@@ -0,0 +1,160 @@
+#include "key_change_log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace replicated_splinterdb {
+
+key_change_log::key_change_log(size_t capacity, size_t key_bytes)
+    : changes_(std::max<size_t>(capacity, 1)),
+      first_(0),
+      count_(0),
+      keys_(key_bytes),
+      keys_head_(0),
+      keys_tail_(0),
+      floor_idx_(0),
+      applied_idx_(0),
+      recording_(false),
+      wanted_(false),
+      last_read_(0),
+      lock_() {}
+
+void key_change_log::reset(uint64_t log_idx) {
+    std::lock_guard<std::mutex> ll(lock_);
+    clear(log_idx);
+}
+
+void key_change_log::clear(uint64_t log_idx) {
+    first_ = 0;
+    count_ = 0;
+    keys_head_ = 0;
+    keys_tail_ = 0;
+    floor_idx_ = std::max(floor_idx_, log_idx);
+}
+
+void key_change_log::evict() {
+    floor_idx_ = std::max(floor_idx_, at(0).log_idx_);
+    first_ = (first_ + 1) % changes_.size();
+    if (--count_ == 0) {
+        keys_head_ = 0;
+        keys_tail_ = 0;
+    } else {
+        keys_head_ = at(0).offset_;
+    }
+}
+
+void key_change_log::record_change(uint64_t log_idx, slice key) {
+    size_t size = slice_length(key);
+
+    std::lock_guard<std::mutex> ll(lock_);
+    if (size > keys_.size()) {
+        // Too big to ever be kept.
+        clear(log_idx);
+        return;
+    }
+
+    if (count_ == changes_.size()) {
+        evict();
+    }
+
+    // Find room for the key, evicting the oldest ones until there is.
+    size_t offset;
+    while (true) {
+        bool wrapped = count_ > 0 && keys_tail_ <= keys_head_;
+        if (wrapped) {
+            if (keys_head_ - keys_tail_ >= size) {
+                offset = keys_tail_;
+                break;
+            }
+        } else if (keys_.size() - keys_tail_ >= size) {
+            offset = keys_tail_;
+            break;
+        } else if (keys_head_ >= size) {
+            offset = 0;
+            break;
+        }
+        evict();
+    }
+
+    if (size > 0) {
+        memcpy(keys_.data() + offset, slice_data(key), size);
+    }
+    if (count_ == 0) {
+        keys_head_ = offset;
+    }
+    keys_tail_ = offset + size;
+
+    changes_[(first_ + count_) % changes_.size()] =
+        change{log_idx, offset, size};
+    ++count_;
+}
+
+void key_change_log::applied(uint64_t log_idx) {
+    applied_idx_.store(log_idx);
+
+    if (!recording_.load(std::memory_order_relaxed)) {
+        if (wanted_.exchange(false)) {
+            // Everything up to here went unrecorded.
+            std::lock_guard<std::mutex> ll(lock_);
+            clear(log_idx);
+            recording_ = true;
+        }
+        return;
+    }
+
+    auto idle =
+        std::chrono::steady_clock::now().time_since_epoch().count() -
+        last_read_.load(std::memory_order_relaxed);
+    if (std::chrono::steady_clock::duration(idle) > READER_TIMEOUT) {
+        std::lock_guard<std::mutex> ll(lock_);
+        recording_ = false;
+        clear(log_idx);
+    }
+}
+
+bool key_change_log::changes_since(uint64_t since_idx, size_t max_keys,
+                                   std::vector<std::vector<uint8_t>>& keys,
+                                   uint64_t& through_idx) const {
+    last_read_.store(
+        std::chrono::steady_clock::now().time_since_epoch().count(),
+        std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> ll(lock_);
+    through_idx = applied_idx_.load();
+    if (!recording_) {
+        wanted_ = true;
+        return false;
+    } else if (since_idx < floor_idx_) {
+        return false;
+    }
+
+    // The first change after `since_idx`.
+    size_t lo = 0;
+    size_t hi = count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (at(mid).log_idx_ <= since_idx) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Never split the keys of one entry, so that `through_idx` is exact.
+    uint64_t last_idx = since_idx;
+    for (size_t i = lo; i < count_ && at(i).log_idx_ <= through_idx; ++i) {
+        const change& c = at(i);
+        if (keys.size() >= max_keys && c.log_idx_ != last_idx) {
+            through_idx = last_idx;
+            return true;
+        }
+
+        const uint8_t* data = keys_.data() + c.offset_;
+        keys.emplace_back(data, data + c.size_);
+        last_idx = c.log_idx_;
+    }
+
+    return true;
+}
+
+}  // namespace replicated_splinterdb
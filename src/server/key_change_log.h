@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "server/splinterdb_wrapper.h"
+
+namespace replicated_splinterdb {
+
+/**
+ * The keys changed by the most recently applied log entries, so that clients
+ * caching values can find out which of them are no longer current. Only the
+ * last `capacity` changes, and only as many keys as fit in `key_bytes`
+ * bytes, are kept. A client asking for older ones is told that they are
+ * gone, and has to assume that every key changed.
+ *
+ * Nothing is recorded until a client asks for changes, and recording stops
+ * again once none has asked for `READER_TIMEOUT`, so that applying entries
+ * costs nothing extra on a server without readers. The changes made while
+ * not recording are unknown.
+ *
+ * Thread-safe. `record` and `applied` are only ever called by the thread
+ * applying entries.
+ */
+class key_change_log {
+  public:
+    // Default number of changed keys kept.
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    // Default room for the bytes of the changed keys kept.
+    static constexpr size_t DEFAULT_KEY_BYTES = 4 * 1024 * 1024;
+
+    // How long recording goes on after the last request for changes.
+    static constexpr std::chrono::seconds READER_TIMEOUT{60};
+
+    explicit key_change_log(size_t capacity = DEFAULT_CAPACITY,
+                            size_t key_bytes = DEFAULT_KEY_BYTES);
+
+    /**
+     * Forget every change, and take the changes of the entries up to and
+     * including `log_idx` as unknown, e.g. while a snapshot is installed.
+     */
+    void reset(uint64_t log_idx);
+
+    /**
+     * Record that the entry at `log_idx`, which is being applied, changes
+     * `key`, if anybody is reading changes.
+     */
+    void record(uint64_t log_idx, slice key) {
+        if (recording_.load(std::memory_order_relaxed)) {
+            record_change(log_idx, key);
+        }
+    }
+
+    /**
+     * Note that every entry up to `log_idx` has been applied.
+     */
+    void applied(uint64_t log_idx);
+
+    /**
+     * Collect the keys changed by the applied entries after `since_idx`,
+     * stopping at the first entry past `max_keys` keys. `through_idx` is set
+     * to the last entry covered. Also keeps changes being recorded for a
+     * while.
+     *
+     * @return `false` if some of those changes are no longer known. No keys
+     *         are collected then, and the caller has to take every key as
+     *         changed up to `through_idx`.
+     */
+    bool changes_since(uint64_t since_idx, size_t max_keys,
+                       std::vector<std::vector<uint8_t>>& keys,
+                       uint64_t& through_idx) const;
+
+  private:
+    // A changed key, whose bytes are in `keys_`.
+    struct change {
+        uint64_t log_idx_;
+        size_t offset_;
+        size_t size_;
+    };
+
+    // A ring of `capacity` changes in log order, starting at `first_`.
+    std::vector<change> changes_;
+    size_t first_;
+    size_t count_;
+
+    // A circular arena holding the bytes of the changed keys. The keys in use
+    // start at `keys_head_`; the next one goes at `keys_tail_`, or at the
+    // start of the arena if it does not fit before the end.
+    std::vector<uint8_t> keys_;
+    size_t keys_head_;
+    size_t keys_tail_;
+
+    // The changes of the entries up to and including this one may be
+    // missing from `changes_`.
+    uint64_t floor_idx_;
+
+    std::atomic<uint64_t> applied_idx_;
+
+    std::atomic<bool> recording_;
+
+    // Set by readers; picked up by `applied` to start recording.
+    mutable std::atomic<bool> wanted_;
+    mutable std::atomic<std::chrono::steady_clock::rep> last_read_;
+
+    mutable std::mutex lock_;
+
+    void record_change(uint64_t log_idx, slice key);
+
+    /**
+     * Drop the oldest change. Requires `lock_`.
+     */
+    void evict();
+
+    /**
+     * Drop every change, taking the entries up to `log_idx` as unknown.
+     * Requires `lock_`.
+     */
+    void clear(uint64_t log_idx);
+
+    const change& at(size_t i) const {
+        return changes_[(first_ + i) % changes_.size()];
+    }
+};
+
+}  // namespace replicated_splinterdb
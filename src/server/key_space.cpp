@@ -0,0 +1,113 @@
+#include "key_space.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace replicated_splinterdb {
+
+static bool has_prefix(slice key, const char* prefix, size_t prefix_size) {
+    return slice_length(key) >= prefix_size &&
+           memcmp(slice_data(key), prefix, prefix_size) == 0;
+}
+
+bool is_reserved_key(slice key) {
+    return has_prefix(key, RESERVED_KEY_PREFIX, RESERVED_KEY_PREFIX_SIZE);
+}
+
+stored_key::stored_key(slice client_key) : escaped_(), key_(client_key) {
+    size_t length = slice_length(client_key);
+    auto* data = static_cast<const char*>(slice_data(client_key));
+    if (length > 0 && data[0] != '\0') {
+        return;
+    }
+
+    escaped_.reserve(ESCAPED_KEY_PREFIX_SIZE + length);
+    escaped_.insert(escaped_.end(), ESCAPED_KEY_PREFIX,
+                    ESCAPED_KEY_PREFIX + ESCAPED_KEY_PREFIX_SIZE);
+    escaped_.insert(escaped_.end(), data, data + length);
+    key_ = slice_create(escaped_.size(), escaped_.data());
+}
+
+slice client_key(slice key) {
+    if (!has_prefix(key, ESCAPED_KEY_PREFIX, ESCAPED_KEY_PREFIX_SIZE)) {
+        return key;
+    }
+
+    auto* data = static_cast<const char*>(slice_data(key));
+    return slice_create(slice_length(key) - ESCAPED_KEY_PREFIX_SIZE,
+                        data + ESCAPED_KEY_PREFIX_SIZE);
+}
+
+slice client_keys_start() {
+    // The empty client key, escaped.
+    return slice_create(ESCAPED_KEY_PREFIX_SIZE, ESCAPED_KEY_PREFIX);
+}
+
+static const data_config* user_config(const data_config* cfg) {
+    // `cfg` is the first member of a `partitioned_data_config`.
+    auto* partitioned = reinterpret_cast<const partitioned_data_config*>(cfg);
+    return &partitioned->user_cfg_;
+}
+
+extern "C" int partitioned_key_compare(const data_config* cfg, slice key1,
+                                       slice key2) {
+    bool reserved1 = is_reserved_key(key1);
+    bool reserved2 = is_reserved_key(key2);
+    if (reserved1 != reserved2) {
+        return reserved1 ? -1 : 1;
+    }
+
+    if (reserved1) {
+        size_t len1 = slice_length(key1);
+        size_t len2 = slice_length(key2);
+        int cmp = memcmp(slice_data(key1), slice_data(key2),
+                         std::min(len1, len2));
+        if (cmp != 0) {
+            return cmp;
+        }
+        return len1 < len2 ? -1 : (len1 > len2 ? 1 : 0);
+    }
+
+    const data_config* user_cfg = user_config(cfg);
+    return user_cfg->key_compare(user_cfg, client_key(key1),
+                                 client_key(key2));
+}
+
+extern "C" int partitioned_merge_tuples(const data_config* cfg, slice key,
+                                        message old_message,
+                                        merge_accumulator* new_message) {
+    const data_config* user_cfg = user_config(cfg);
+    return user_cfg->merge_tuples(user_cfg, client_key(key), old_message,
+                                  new_message);
+}
+
+extern "C" int partitioned_merge_tuples_final(
+    const data_config* cfg, slice key, merge_accumulator* oldest_message) {
+    const data_config* user_cfg = user_config(cfg);
+    return user_cfg->merge_tuples_final(user_cfg, client_key(key),
+                                        oldest_message);
+}
+
+extern "C" void partitioned_key_to_string(const data_config* cfg, slice key,
+                                          char* str, size_t max_len) {
+    const data_config* user_cfg = user_config(cfg);
+    user_cfg->key_to_string(user_cfg, client_key(key), str, max_len);
+}
+
+void partitioned_data_config_init(const data_config& user_cfg,
+                                  partitioned_data_config* out_cfg) {
+    out_cfg->user_cfg_ = user_cfg;
+    out_cfg->cfg_ = user_cfg;
+    out_cfg->cfg_.key_compare = partitioned_key_compare;
+    if (user_cfg.merge_tuples) {
+        out_cfg->cfg_.merge_tuples = partitioned_merge_tuples;
+    }
+    if (user_cfg.merge_tuples_final) {
+        out_cfg->cfg_.merge_tuples_final = partitioned_merge_tuples_final;
+    }
+    if (user_cfg.key_to_string) {
+        out_cfg->cfg_.key_to_string = partitioned_key_to_string;
+    }
+}
+
+}  // namespace replicated_splinterdb
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "server/splinterdb_wrapper.h"
+
+namespace replicated_splinterdb {
+
+/**
+ * Keys starting with two NUL bytes belong to the server itself rather than to
+ * clients: the applied index of the state machine, and the Raft log when it
+ * shares the state machine's SplinterDB instance. The byte after the prefix
+ * names the partition.
+ *
+ * Client keys that are empty or start with a NUL byte are stored behind
+ * `ESCAPED_KEY_PREFIX`, so no client key is ever stored as a reserved one and
+ * every client key is usable. Stored that way, client keys keep their
+ * bytewise order and all sort after the reserved keys.
+ */
+static constexpr char RESERVED_KEY_PREFIX[] = {'\0', '\0'};
+static constexpr size_t RESERVED_KEY_PREFIX_SIZE = sizeof(RESERVED_KEY_PREFIX);
+
+static constexpr char ESCAPED_KEY_PREFIX[] = {'\0', '\x01'};
+static constexpr size_t ESCAPED_KEY_PREFIX_SIZE = sizeof(ESCAPED_KEY_PREFIX);
+
+static constexpr char META_PARTITION = 'M';
+static constexpr char LOG_PARTITION = 'L';
+
+/**
+ * @return `true` if the stored key `key` is a reserved one.
+ */
+bool is_reserved_key(slice key);
+
+/**
+ * The key a client key is stored under. Refers to the client key itself
+ * unless it has to be escaped.
+ */
+class stored_key {
+  public:
+    explicit stored_key(slice client_key);
+
+    stored_key(const stored_key&) = delete;
+
+    stored_key& operator=(const stored_key&) = delete;
+
+    slice get() const { return key_; }
+
+  private:
+    std::vector<char> escaped_;
+    slice key_;
+};
+
+/**
+ * The client key stored as `key`, which must not be a reserved one. Points
+ * into `key`.
+ */
+slice client_key(slice key);
+
+/**
+ * The smallest stored client key, where iterating over all client keys
+ * starts.
+ */
+slice client_keys_start();
+
+/**
+ * A copy of a client `data_config` whose key comparison puts every reserved
+ * key before every client key, orders reserved keys bytewise, and compares
+ * client keys as the client would, escaped or not. Iterating from any client
+ * key thus never runs into the reserved ones, and a Raft log sharing the
+ * instance sorts as a range of its own whatever the client's comparison is.
+ *
+ * The client's other callbacks that take a key get the client key as well,
+ * never an escaped one. `key_hash` is the exception: SplinterDB hands it
+ * the stored bytes without a config, so it hashes escaped keys as they are.
+ *
+ * SplinterDB only sees `cfg_`; the callbacks find their way back to
+ * `user_cfg_` through it.
+ */
+struct partitioned_data_config {
+    data_config cfg_;
+    data_config user_cfg_;
+};
+
+void partitioned_data_config_init(const data_config& user_cfg,
+                                  partitioned_data_config* out_cfg);
+
+}  // namespace replicated_splinterdb
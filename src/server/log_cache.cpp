@@ -0,0 +1,99 @@
+#include "log_cache.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace replicated_splinterdb {
+
+using nuraft::buffer;
+using nuraft::ptr;
+
+void term_index::append(uint64_t index, uint64_t term) {
+    if (runs_.empty()) {
+        begin_ = index;
+    } else if (index != end_) {
+        // Not contiguous; start over rather than record a wrong range.
+        clear();
+        begin_ = index;
+    }
+
+    if (runs_.empty() || runs_.rbegin()->second != term) {
+        runs_.emplace_hint(runs_.end(), index, term);
+    }
+    end_ = index + 1;
+}
+
+void term_index::append_run(uint64_t first, uint64_t last, uint64_t term) {
+    append(first, term);
+    end_ = last + 1;
+}
+
+void term_index::truncate(uint64_t index) {
+    if (index <= begin_) {
+        clear();
+        return;
+    }
+
+    runs_.erase(runs_.lower_bound(index), runs_.end());
+    end_ = std::min(end_, index);
+}
+
+void term_index::compact(uint64_t last_index) {
+    if (last_index + 1 >= end_) {
+        clear();
+        return;
+    }
+
+    // Drop the runs that end before the new first entry.
+    while (runs_.size() > 1 &&
+           std::next(runs_.begin())->first <= last_index + 1) {
+        runs_.erase(runs_.begin());
+    }
+    begin_ = std::max(begin_, last_index + 1);
+}
+
+std::optional<uint64_t> term_index::term_at(uint64_t index) const {
+    if (runs_.empty() || index < begin_ || index >= end_) {
+        return std::nullopt;
+    }
+
+    auto run = runs_.upper_bound(index);
+    return std::prev(run)->second;
+}
+
+void term_index::clear() {
+    runs_.clear();
+    begin_ = 0;
+    end_ = 0;
+}
+
+tail_cache::tail_cache(size_t capacity) : slots_(capacity) {}
+
+void tail_cache::put(uint64_t index, ptr<buffer> data) {
+    if (slots_.empty()) {
+        return;
+    }
+
+    slot& s = slots_[index % slots_.size()];
+    s.index_ = index;
+    s.data_ = std::move(data);
+}
+
+ptr<buffer> tail_cache::get(uint64_t index) const {
+    if (slots_.empty()) {
+        return nullptr;
+    }
+
+    const slot& s = slots_[index % slots_.size()];
+    return s.data_ && s.index_ == index ? s.data_ : nullptr;
+}
+
+void tail_cache::truncate(uint64_t index) {
+    for (slot& s : slots_) {
+        if (s.data_ && s.index_ >= index) {
+            s.data_.reset();
+        }
+    }
+}
+
+}  // namespace replicated_splinterdb
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "libnuraft/nuraft.hxx"
+
+namespace replicated_splinterdb {
+
+/**
+ * Hit counters of the in-memory caches in front of a persistent log store.
+ */
+struct log_cache_stats {
+    uint64_t entry_hits_ = 0;
+    uint64_t entry_misses_ = 0;
+    uint64_t term_hits_ = 0;
+    uint64_t term_misses_ = 0;
+
+    double entry_hit_rate() const {
+        uint64_t total = entry_hits_ + entry_misses_;
+        return total ? static_cast<double>(entry_hits_) /
+                         static_cast<double>(total)
+                   : 0.0;
+    }
+
+    double term_hit_rate() const {
+        uint64_t total = term_hits_ + term_misses_;
+        return total ? static_cast<double>(term_hits_) /
+                         static_cast<double>(total)
+                   : 0.0;
+    }
+};
+
+/**
+ * The terms of a contiguous range of log entries, run-length encoded. Terms
+ * only change on elections, so a handful of runs covers the whole log.
+ *
+ * Not thread-safe.
+ */
+class term_index {
+  public:
+    /**
+     * Record the term of the entry at `index`, which must directly follow
+     * the last recorded entry unless the index is empty.
+     */
+    void append(uint64_t index, uint64_t term);
+
+    /**
+     * Record that the entries from `first` to `last` all have `term`, as if
+     * they were appended one by one.
+     */
+    void append_run(uint64_t first, uint64_t last, uint64_t term);
+
+    /**
+     * Forget the entries from `index` on.
+     */
+    void truncate(uint64_t index);
+
+    /**
+     * Forget the entries up to and including `last_index`.
+     */
+    void compact(uint64_t last_index);
+
+    /**
+     * @return The term of the entry at `index`, if it is covered.
+     */
+    std::optional<uint64_t> term_at(uint64_t index) const;
+
+    void clear();
+
+  private:
+    // Term of each run, by the index of the run's first entry.
+    std::map<uint64_t, uint64_t> runs_;
+
+    // First index covered, and one past the last.
+    uint64_t begin_ = 0;
+    uint64_t end_ = 0;
+};
+
+/**
+ * A ring of the most recently appended serialized log entries, so that
+ * entries that are replicated while they are fresh are served from memory.
+ *
+ * Not thread-safe.
+ */
+class tail_cache {
+  public:
+    explicit tail_cache(size_t capacity);
+
+    /**
+     * Cache the serialized entry at `index`, evicting whatever entry shared
+     * its slot.
+     */
+    void put(uint64_t index, nuraft::ptr<nuraft::buffer> data);
+
+    /**
+     * @return The serialized entry at `index`, or null if it is not cached.
+     *         The buffer is shared; callers must not move its position.
+     */
+    nuraft::ptr<nuraft::buffer> get(uint64_t index) const;
+
+    /**
+     * Drop the entries from `index` on.
+     */
+    void truncate(uint64_t index);
+
+    size_t capacity() const { return slots_.size(); }
+
+  private:
+    struct slot {
+        uint64_t index_ = 0;
+        nuraft::ptr<nuraft::buffer> data_;
+    };
+
+    std::vector<slot> slots_;
+};
+
+}  // namespace replicated_splinterdb
@@ -0,0 +1,83 @@
+#include "log_pack.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "common/crc32c.h"
+
+namespace replicated_splinterdb {
+
+using nuraft::buffer;
+using nuraft::byte;
+using nuraft::ptr;
+
+ptr<buffer> log_pack_create(size_t count, size_t bytes) {
+    ptr<buffer> pack =
+        buffer::alloc(sizeof(int32_t) +
+                      count * (sizeof(int32_t) + LOG_CHECKSUM_SIZE) + bytes);
+    pack->pos(0);
+    pack->put(static_cast<int32_t>(count));
+    return pack;
+}
+
+void log_pack_put(buffer& pack, const byte* data, uint32_t size,
+                  uint32_t crc) {
+    memcpy(log_pack_reserve(pack, size, crc), data, size);
+}
+
+byte* log_pack_reserve(buffer& pack, uint32_t size, uint32_t crc) {
+    byte checksum[LOG_CHECKSUM_SIZE];
+    put_log_checksum(checksum, crc);
+
+    pack.put(static_cast<int32_t>(size));
+    pack.put_raw(checksum, sizeof(checksum));
+
+    byte* data = pack.data();
+    pack.pos(pack.pos() + size);
+    return data;
+}
+
+const byte* log_pack_get(buffer& pack, uint32_t& size) {
+    int32_t signed_size = pack.get_int();
+    if (signed_size <= 0) {
+        throw std::runtime_error("Invalid log entry size");
+    }
+    size = static_cast<uint32_t>(signed_size);
+
+    uint32_t crc = get_log_checksum(pack.get_raw(LOG_CHECKSUM_SIZE));
+    const byte* data = pack.get_raw(size);
+    if (crc32c(data, size) != crc) {
+        throw std::runtime_error("Corrupted log entry in log pack");
+    }
+    return data;
+}
+
+void put_log_checksum(byte* out, uint32_t crc) {
+    for (size_t i = 0; i < LOG_CHECKSUM_SIZE; ++i) {
+        out[i] = static_cast<byte>(crc >> (8 * i));
+    }
+}
+
+uint32_t get_log_checksum(const byte* in) {
+    uint32_t crc = 0;
+    for (size_t i = 0; i < LOG_CHECKSUM_SIZE; ++i) {
+        crc |= static_cast<uint32_t>(in[i]) << (8 * i);
+    }
+    return crc;
+}
+
+uint64_t get_log_term(const byte* entry, uint32_t size) {
+    // A serialized entry starts with its term, little-endian like every
+    // number NuRaft puts into a buffer.
+    if (size < sizeof(uint64_t)) {
+        throw std::runtime_error("Truncated log entry header");
+    }
+
+    uint64_t term = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        term |= static_cast<uint64_t>(entry[i]) << (8 * i);
+    }
+    return term;
+}
+
+}  // namespace replicated_splinterdb
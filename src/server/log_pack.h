@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+#include "libnuraft/nuraft.hxx"
+
+namespace replicated_splinterdb {
+
+/**
+ * The format of the log packs that log stores exchange through `pack` and
+ * `apply_pack`, shared by all of them so that servers with different log
+ * stores can still catch each other up.
+ *
+ * A pack holds the number of entries, and then for every entry its size, the
+ * CRC32C of the serialized entry and the serialized entry itself. The
+ * checksum is stored little-endian right in front of the entry, so a store
+ * that keeps entries in the same checksum-first form can copy both in one
+ * piece.
+ */
+static constexpr size_t LOG_CHECKSUM_SIZE = sizeof(uint32_t);
+
+/**
+ * Start a pack of `count` entries, `bytes` bytes in total once serialized.
+ */
+nuraft::ptr<nuraft::buffer> log_pack_create(size_t count, size_t bytes);
+
+/**
+ * Append a serialized entry and its checksum to `pack`.
+ */
+void log_pack_put(nuraft::buffer& pack, const nuraft::byte* data,
+                  uint32_t size, uint32_t crc);
+
+/**
+ * Append the header of an entry of `size` bytes to `pack`.
+ *
+ * @return Where the caller writes the serialized entry itself.
+ */
+nuraft::byte* log_pack_reserve(nuraft::buffer& pack, uint32_t size,
+                               uint32_t crc);
+
+/**
+ * Read the next entry of `pack`, and check it against its checksum.
+ *
+ * @return The serialized entry, pointing into `pack`. The checksum directly
+ *         precedes it.
+ * @throws std::runtime_error If the entry is malformed or corrupted.
+ */
+const nuraft::byte* log_pack_get(nuraft::buffer& pack, uint32_t& size);
+
+void put_log_checksum(nuraft::byte* out, uint32_t crc);
+
+uint32_t get_log_checksum(const nuraft::byte* in);
+
+/**
+ * @return The term of the serialized entry `entry`, read from its header
+ *         without deserializing the rest.
+ * @throws std::runtime_error If the entry is too short to hold a header.
+ */
+uint64_t get_log_term(const nuraft::byte* entry, uint32_t size);
+
+}  // namespace replicated_splinterdb
@@ -0,0 +1,203 @@
+#include "log_syncer.h"
+
+#include <algorithm>
+
+namespace replicated_splinterdb {
+
+log_syncer::log_syncer(const log_sync_options& options,
+                       std::function<bool()> sync)
+    : mode_(options.durability_),
+      interval_(options.interval_us_),
+      sync_bytes_(options.bytes_),
+      in_background_(options.in_background_),
+      sync_(std::move(sync)),
+      lock_(),
+      synced_cv_(),
+      pending_cv_(),
+      written_seq_(0),
+      synced_seq_(0),
+      written_idx_(0),
+      durable_idx_(0),
+      truncations_(0),
+      unsynced_bytes_(0),
+      first_unsynced_(),
+      syncing_(false),
+      stopped_(false),
+      on_durable_(),
+      background_() {
+    if (mode_ != log_durability::NONE && in_background_) {
+        background_ = std::thread([this] { background_loop(); });
+    }
+}
+
+log_syncer::~log_syncer() { stop(); }
+
+void log_syncer::stop() {
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+        stopped_ = true;
+    }
+    pending_cv_.notify_all();
+
+    if (background_.joinable()) {
+        background_.join();
+    }
+}
+
+void log_syncer::reset(uint64_t last_log_idx) {
+    std::lock_guard<std::mutex> lk(lock_);
+    written_idx_ = last_log_idx;
+    durable_idx_ = last_log_idx;
+}
+
+void log_syncer::compacted(uint64_t last_log_idx) {
+    std::lock_guard<std::mutex> lk(lock_);
+    written_idx_ = std::max(written_idx_, last_log_idx);
+    durable_idx_ = std::max(durable_idx_, last_log_idx);
+}
+
+uint64_t log_syncer::written(size_t bytes, uint64_t last_log_idx,
+                             uint64_t truncated_from) {
+    std::lock_guard<std::mutex> lk(lock_);
+    if (truncated_from > 0) {
+        ++truncations_;
+        durable_idx_ = std::min(durable_idx_, truncated_from - 1);
+    }
+    written_idx_ = last_log_idx;
+
+    if (unsynced_bytes_ == 0) {
+        first_unsynced_ = std::chrono::steady_clock::now();
+    }
+    unsynced_bytes_ += bytes;
+
+    // Wake the background thread for the first pending write, for every
+    // write that it should sync right away, and once enough has piled up.
+    if (unsynced_bytes_ == bytes || unsynced_bytes_ >= sync_bytes_ ||
+        mode_ == log_durability::PER_APPEND) {
+        pending_cv_.notify_one();
+    }
+    if (!in_background_ && unsynced_bytes_ >= sync_bytes_) {
+        synced_cv_.notify_all();
+    }
+
+    return ++written_seq_;
+}
+
+bool log_syncer::on_append(uint64_t ticket) {
+    if (mode_ == log_durability::NONE || in_background_) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lk(lock_);
+    if (mode_ == log_durability::GROUP_COMMIT) {
+        // Give concurrent appends until the interval is up to pile on. Then
+        // whoever still finds its write unsynced leads a sync that covers
+        // every pending write, and the others wait for it.
+        auto deadline = first_unsynced_ + interval_;
+        synced_cv_.wait_until(lk, deadline, [this, ticket] {
+            return synced_seq_ >= ticket || unsynced_bytes_ >= sync_bytes_;
+        });
+    }
+
+    return sync_through(lk, ticket);
+}
+
+bool log_syncer::sync_all() {
+    if (mode_ == log_durability::NONE) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lk(lock_);
+    return sync_through(lk, written_seq_);
+}
+
+uint64_t log_syncer::durable_index() {
+    std::lock_guard<std::mutex> lk(lock_);
+    return mode_ == log_durability::NONE ? written_idx_ : durable_idx_;
+}
+
+void log_syncer::set_durable_callback(std::function<void()> on_durable) {
+    bool call;
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+        on_durable_ = on_durable;
+        call = durable_idx_ > 0;
+    }
+
+    if (call && on_durable) {
+        on_durable();
+    }
+}
+
+bool log_syncer::sync_through(std::unique_lock<std::mutex>& lk, uint64_t seq) {
+    while (synced_seq_ < seq) {
+        if (syncing_) {
+            // Somebody else is syncing; their sync may or may not cover us.
+            synced_cv_.wait(lk);
+            continue;
+        }
+
+        // Everything written so far is covered by this sync, so writers that
+        // show up while it runs only wait for the next one.
+        syncing_ = true;
+        uint64_t target = written_seq_;
+        uint64_t target_idx = written_idx_;
+        uint64_t truncations = truncations_;
+        unsynced_bytes_ = 0;
+
+        lk.unlock();
+        bool ok = sync_();
+        lk.lock();
+
+        syncing_ = false;
+        bool advanced = false;
+        if (ok) {
+            synced_seq_ = std::max(synced_seq_, target);
+            if (truncations == truncations_ && target_idx > durable_idx_) {
+                durable_idx_ = target_idx;
+                advanced = true;
+            }
+        }
+        synced_cv_.notify_all();
+
+        if (advanced && on_durable_) {
+            std::function<void()> on_durable = on_durable_;
+            lk.unlock();
+            on_durable();
+            lk.lock();
+        }
+
+        if (!ok) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void log_syncer::background_loop() {
+    std::unique_lock<std::mutex> lk(lock_);
+    while (!stopped_) {
+        pending_cv_.wait(lk, [this] {
+            return stopped_ || written_seq_ > synced_seq_;
+        });
+
+        if (mode_ == log_durability::GROUP_COMMIT) {
+            // Give concurrent appends until the interval is up to pile on.
+            pending_cv_.wait_until(lk, first_unsynced_ + interval_, [this] {
+                return stopped_ || unsynced_bytes_ >= sync_bytes_;
+            });
+        }
+        if (stopped_) {
+            break;
+        }
+
+        if (!sync_through(lk, written_seq_)) {
+            // Back off rather than retrying a failing sync in a tight loop.
+            auto backoff = std::max(interval_, std::chrono::microseconds(1000));
+            pending_cv_.wait_for(lk, backoff, [this] { return stopped_; });
+        }
+    }
+}
+
+}  // namespace replicated_splinterdb
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "server/log_durability.h"
+
+namespace replicated_splinterdb {
+
+/**
+ * How a log store syncs appended entries; see `log_durability`.
+ */
+struct log_sync_options {
+    log_durability durability_ = log_durability::GROUP_COMMIT;
+
+    // GROUP_COMMIT only: the longest an append waits to be synced, and the
+    // number of pending bytes that triggers a sync right away.
+    uint64_t interval_us_ = 1000;
+    uint64_t bytes_ = 1024 * 1024;
+
+    // Never make appends wait for a sync; the background thread syncs them
+    // instead (right away for PER_APPEND), and progress is reported through
+    // `durable_index` and the durable callback. This is what NuRaft's
+    // parallel log appending expects from a log store.
+    bool in_background_ = false;
+};
+
+/**
+ * Decides when a log store syncs what it has written, batches concurrent
+ * requests to sync into a single call to `sync`, and keeps track of the last
+ * log index known to be durable.
+ *
+ * Writers report every write with `written`, once the data has been handed to
+ * the OS, and then call `on_append` outside of any lock that other writers
+ * need, so that they can join the same sync.
+ */
+class log_syncer {
+  public:
+    log_syncer(const log_sync_options& options, std::function<bool()> sync);
+
+    ~log_syncer();
+
+    log_syncer(const log_syncer&) = delete;
+
+    log_syncer& operator=(const log_syncer&) = delete;
+
+    /**
+     * Take every entry up to `last_log_idx` as durable, e.g. after recovering
+     * them from disk. Must be called before any write is reported.
+     */
+    void reset(uint64_t last_log_idx);
+
+    /**
+     * Note that every entry up to `last_log_idx` has been compacted away.
+     * Compacting past the end of the log (e.g. when installing a snapshot)
+     * moves the end of the log, and with it the durable index.
+     */
+    void compacted(uint64_t last_log_idx);
+
+    /**
+     * Record a write of `bytes` bytes that leaves `last_log_idx` as the last
+     * entry of the log. A write that first dropped every entry from some
+     * index on must pass that index as `truncated_from`, since durable
+     * entries past it are gone.
+     *
+     * @return A ticket identifying the write.
+     */
+    uint64_t written(size_t bytes, uint64_t last_log_idx,
+                     uint64_t truncated_from = 0);
+
+    /**
+     * Sync the write identified by `ticket` if the durability mode requires
+     * it to be durable before the append returns. In GROUP_COMMIT mode, the
+     * caller waits for the sync of the group its write falls in.
+     *
+     * @return `false` if syncing failed.
+     */
+    bool on_append(uint64_t ticket);
+
+    /**
+     * Sync everything written so far, unless the mode is NONE.
+     *
+     * @return `false` if syncing failed.
+     */
+    bool sync_all();
+
+    /**
+     * The last log index known to be durable. Without a durability mode,
+     * every written entry counts as durable.
+     */
+    uint64_t durable_index();
+
+    /**
+     * Call `on_durable` whenever `durable_index` moves forward because of a
+     * sync. Called right away if anything is durable already.
+     */
+    void set_durable_callback(std::function<void()> on_durable);
+
+    /**
+     * Stop the background thread. Nothing is synced automatically afterwards.
+     */
+    void stop();
+
+  private:
+    const log_durability mode_;
+    const std::chrono::microseconds interval_;
+    const uint64_t sync_bytes_;
+    const bool in_background_;
+    const std::function<bool()> sync_;
+
+    std::mutex lock_;
+
+    // Signalled whenever a sync finishes, and when enough has piled up for
+    // appends waiting on a group commit to sync right away.
+    std::condition_variable synced_cv_;
+
+    // Signalled when there is something for the background thread to do.
+    std::condition_variable pending_cv_;
+
+    // Ticket of the last write, and of the last write known to be durable.
+    uint64_t written_seq_;
+    uint64_t synced_seq_;
+
+    // Last log index written, and last one known to be durable.
+    uint64_t written_idx_;
+    uint64_t durable_idx_;
+
+    // Bumped by every truncation, so that a sync running across one does not
+    // take entries that it never covered as durable.
+    uint64_t truncations_;
+
+    // Bytes written since the last sync started, and when the first of them
+    // was written.
+    uint64_t unsynced_bytes_;
+    std::chrono::steady_clock::time_point first_unsynced_;
+
+    bool syncing_;
+    bool stopped_;
+
+    std::function<void()> on_durable_;
+
+    // Syncs every write in the background mode.
+    std::thread background_;
+
+    bool sync_through(std::unique_lock<std::mutex>& lk, uint64_t seq);
+
+    void background_loop();
+};
+
+}  // namespace replicated_splinterdb
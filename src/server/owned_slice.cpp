@@ -34,6 +34,11 @@ void owned_slice::deserialize(owned_slice& slice_out, buffer_serializer& bs) {
     slice_out.data_.assign(bytes, bytes + len);
 }
 
+slice owned_slice::deserialize_view(buffer_serializer& bs) {
+    size_t len = bs.get_u64();
+    return slice_create(len, bs.get_raw(len));
+}
+
 size_t owned_slice::serialized_size() const {
     return sizeof(uint64_t) + data_.size();
 }
@@ -0,0 +1,60 @@
+#include "read_pool.h"
+
+namespace replicated_splinterdb {
+
+read_pool::read_pool(size_t num_threads, std::function<void()> thread_init,
+                     std::function<void()> thread_exit)
+    : workers_(), tasks_(), lock_(), cv_(), stopped_(false) {
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_.emplace_back([this, thread_init, thread_exit] {
+            run(thread_init, thread_exit);
+        });
+    }
+}
+
+read_pool::~read_pool() {
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+        stopped_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void read_pool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void read_pool::run(const std::function<void()>& thread_init,
+                    const std::function<void()>& thread_exit) {
+    thread_init();
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lk(lock_);
+            cv_.wait(lk, [this] { return stopped_ || !tasks_.empty(); });
+
+            if (tasks_.empty()) {
+                break;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+
+    thread_exit();
+}
+
+}  // namespace replicated_splinterdb
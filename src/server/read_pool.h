@@ -0,0 +1,46 @@
+#ifndef REPLICATED_SPLINTERDB_READ_POOL_H
+#define REPLICATED_SPLINTERDB_READ_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace replicated_splinterdb {
+
+/**
+ * A fixed set of worker threads used to spread large read requests over
+ * several cores. `thread_init` and `thread_exit` run once on every worker,
+ * which lets each worker register with SplinterDB for its whole lifetime.
+ */
+class read_pool {
+  public:
+    read_pool(size_t num_threads, std::function<void()> thread_init,
+              std::function<void()> thread_exit);
+
+    ~read_pool();
+
+    read_pool(const read_pool&) = delete;
+
+    read_pool& operator=(const read_pool&) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    void submit(std::function<void()> task);
+
+  private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex lock_;
+    std::condition_variable cv_;
+    bool stopped_;
+
+    void run(const std::function<void()>& thread_init,
+             const std::function<void()>& thread_exit);
+};
+
+}  // namespace replicated_splinterdb
+
+#endif  // REPLICATED_SPLINTERDB_READ_POOL_H
@@ -1,10 +1,20 @@
 #include "server/replica.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <iostream>
 
+#include "file_log_store.h"
+#include "file_state_mgr.h"
+#include "in_memory_log_store.h"
 #include "in_memory_state_mgr.hxx"
+#include "key_space.h"
 #include "logger.h"
+#include "read_pool.h"
+#include "splinterdb_log_store.h"
 #include "server/splinterdb_wrapper.h"
 #include "splinterdb_state_machine.h"
 
@@ -16,21 +26,40 @@ namespace replicated_splinterdb {
 
 using nuraft::asio_service;
 using nuraft::buffer;
+using nuraft::buffer_serializer;
+using nuraft::cb_func;
 using nuraft::cmd_result_code;
 using nuraft::cs_new;
 using nuraft::inmem_state_mgr;
 using nuraft::ptr;
 using nuraft::raft_params;
+using nuraft::raft_server;
 using nuraft::srv_config;
 
+// Size of the per-thread lookup buffer that values are read into. It grows to
+// fit larger values, up to `MAX_LOOKUP_BUFFER_SIZE`; anything bigger is
+// allocated by SplinterDB for that read only.
+static constexpr size_t INITIAL_LOOKUP_BUFFER_SIZE = 4 * 1024;
+static constexpr size_t MAX_LOOKUP_BUFFER_SIZE = 1024 * 1024;
+
+static uint64_t clock_us() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+static std::vector<uint8_t> slice_to_vector(slice s) {
+    auto* bytes = static_cast<const uint8_t*>(slice_data(s));
+    return std::vector<uint8_t>(bytes, bytes + slice_length(s));
+}
+
 void replica::default_raft_params_init(raft_params& params) {
     // heartbeat: 100 ms, election timeout: 200 - 400 ms.
     params.heart_beat_interval_ = 100;
     params.election_timeout_lower_bound_ = 300;
     params.election_timeout_upper_bound_ = 500;
 
-    // Up to 5 logs will be preserved ahead the last snapshot.
-    params.reserved_log_items_ = 1000000;
     // Client timeout: 3000 ms.
     params.client_req_timeout_ = 3000;
     // According to this method, `append_log` function
@@ -38,6 +67,10 @@ void replica::default_raft_params_init(raft_params& params) {
     params.return_method_ = raft_params::blocking;
 
     params.auto_forwarding_ = true;
+
+    // Replicate log entries while they are still being synced locally, as long
+    // as the log store supports it (see `syncs_log_in_background`).
+    params.parallel_log_appending_ = true;
 }
 
 replica::replica(const replica_config& config)
@@ -52,11 +85,22 @@ replica::replica(const replica_config& config)
       sm_(nullptr),
       smgr_(nullptr),
       launcher_(),
-      raft_instance_(nullptr) {
+      raft_instance_(nullptr),
+      read_pool_(nullptr) {
     if (!config_.server_id_) {
         throw std::invalid_argument("server_id must be set");
     }
 
+    // A SplinterDB log store cannot sync its entries, so it would report them
+    // as durable when they are not.
+    bool splinterdb_log =
+        config_.log_store_type_ == log_store_type::SPLINTERDB ||
+        config_.log_store_type_ == log_store_type::SHARED_SPLINTERDB;
+    if (splinterdb_log && config_.log_durability_ != log_durability::NONE) {
+        throw std::invalid_argument(
+            "a SplinterDB log store requires a log durability of NONE");
+    }
+
     if (!std::filesystem::create_directories(".logs")) {
         std::cout << ".logs already exists ... skipping create" << std::endl;
     }
@@ -79,31 +123,111 @@ replica::replica(const replica_config& config)
     spl_log_file_ = fopen(spl_log_file_name.c_str(), "w");
     platform_set_log_streams(spl_log_file_, spl_log_file_);
 
-    // Initialize SplinterDB state machine and state manager
-    sm_ = cs_new<splinterdb_state_machine>(config_.splinterdb_cfg_,
-                                           config_.snapshot_frequency_ <= 0);
-    smgr_ =
-        cs_new<inmem_state_mgr>(server_id_, raft_endpoint_, client_endpoint_);
+    // Initialize SplinterDB state machine and state manager. With a
+    // persistent log, everything else is kept on disk as well, so that a
+    // restarted server picks up where it left off.
+    bool durable = config_.log_store_type_ != log_store_type::IN_MEMORY;
+    sm_ = cs_new<splinterdb_state_machine>(
+        config_.splinterdb_cfg_, logger_, config_.snapshot_frequency_ <= 0,
+        config_.snapshot_chunk_size_, durable);
+    if (durable) {
+        smgr_ = cs_new<file_state_mgr>(
+            server_id_, raft_endpoint_, client_endpoint_,
+            config_.state_dir_.value_or("raft-state-" +
+                                        std::to_string(server_id_)),
+            make_log_store());
+        sm_->recover(*smgr_->load_log_store());
+    } else {
+        smgr_ = cs_new<inmem_state_mgr>(server_id_, raft_endpoint_,
+                                        client_endpoint_, make_log_store());
+    }
 
     initialize();
+
+    if (config_.read_threads_ > 0) {
+        splinterdb* spl_handle = sm_->get_splinterdb_handle();
+        read_pool_ = std::make_unique<read_pool>(
+            config_.read_threads_,
+            [spl_handle] { splinterdb_register_thread(spl_handle); },
+            [spl_handle] { splinterdb_deregister_thread(spl_handle); });
+    }
 }
 
-replica::~replica() { fclose(spl_log_file_); }
+replica::~replica() {
+    read_pool_.reset();
+    fclose(spl_log_file_);
+}
+
+bool replica::syncs_log_in_background() const {
+    // Only a file log store syncs at all; SplinterDB log stores would report
+    // entries as durable that are not.
+    return config_.parallel_log_appending_ &&
+           config_.log_store_type_ == log_store_type::FILE &&
+           config_.log_durability_ != log_durability::NONE;
+}
+
+ptr<nuraft::log_store> replica::make_log_store() const {
+    log_sync_options sync;
+    sync.durability_ = config_.log_durability_;
+    sync.interval_us_ = config_.log_sync_interval_us_;
+    sync.bytes_ = config_.log_sync_bytes_;
+    sync.in_background_ = syncs_log_in_background();
+
+    switch (config_.log_store_type_) {
+        case log_store_type::SPLINTERDB:
+            return cs_new<splinterdb_log_store>(
+                "log" + std::to_string(server_id_) + ".db", sync,
+                config_.log_tail_cache_entries_);
+        case log_store_type::SHARED_SPLINTERDB:
+            if (config_.splinterdb_data_cfg_.max_key_size <
+                splinterdb_log_store::SHARED_KEY_SIZE) {
+                throw std::invalid_argument(
+                    "max_key_size is too small for a shared log store");
+            }
+            return cs_new<splinterdb_log_store>(
+                sm_->get_splinterdb_handle(), sm_,
+                config_.splinterdb_cfg_.filename, sync,
+                config_.log_tail_cache_entries_);
+        case log_store_type::FILE:
+            return cs_new<file_log_store>(
+                config_.log_store_dir_.value_or(
+                    "raft-log-" + std::to_string(server_id_)),
+                config_.log_segment_size_, sync);
+        case log_store_type::IN_MEMORY:
+        default:
+            return cs_new<nuraft::inmem_log_store>();
+    }
+}
 
 void replica::initialize() {
     raft_params params;
     default_raft_params_init(params);
     params.snapshot_distance_ = std::max(0, config_.snapshot_frequency_);
+    params.reserved_log_items_ = static_cast<int32_t>(
+        std::min<size_t>(config_.reserved_log_entries_, INT32_MAX));
 
     params.return_method_ = config_.get_return_method();
+    params.parallel_log_appending_ =
+        params.parallel_log_appending_ && syncs_log_in_background();
+
+    if (config_.read_lease_ms_ >=
+        static_cast<size_t>(params.election_timeout_lower_bound_)) {
+        throw std::invalid_argument(
+            "read lease must be shorter than the election timeout");
+    }
 
     asio_service::options asio_opt;
     asio_opt.thread_pool_size_ = config_.asio_thread_pool_size_;
     // asio_opt.worker_start_ = [](uint32_t) { };
     // asio_opt.worker_stop_ = [](uint32_t) { };
 
-    raft_instance_ =
-        launcher_.init(sm_, smgr_, logger_, raft_port_, asio_opt, params);
+    raft_server::init_options opt;
+    opt.raft_callback_ = [this](cb_func::Type type, cb_func::Param* param) {
+        return on_raft_event(type, param);
+    };
+
+    raft_instance_ = launcher_.init(sm_, smgr_, logger_, raft_port_,
+                                    asio_opt, params, opt);
 
     if (!raft_instance_) {
         std::cerr << "Failed to initialize launcher (see the message "
@@ -113,6 +237,15 @@ void replica::initialize() {
         exit(-1);
     }
 
+    sm_->set_raft_server(raft_instance_.get());
+
+    // With parallel log appending, the log store tells Raft when entries it
+    // synced in the background have become durable.
+    ptr<nuraft::log_store> store = smgr_->load_log_store();
+    if (auto file_store = std::dynamic_pointer_cast<file_log_store>(store)) {
+        file_store->set_raft_server(raft_instance_.get());
+    }
+
     // Wait until Raft server is ready (up to 5 seconds).
     std::cout << "Initializing Raft instance ";
     for (size_t ii = 0; ii < config_.initialization_retries_; ++ii) {
@@ -132,6 +265,13 @@ void replica::initialize() {
 }
 
 void replica::shutdown(size_t time_limit_sec) {
+    // The log store outlives the Raft server, so it must stop calling back
+    // into it first.
+    ptr<nuraft::log_store> store = smgr_->load_log_store();
+    if (auto file_store = std::dynamic_pointer_cast<file_log_store>(store)) {
+        file_store->detach_raft_server();
+    }
+
     launcher_.shutdown(time_limit_sec);
 }
 
@@ -141,6 +281,16 @@ void replica::register_thread() {
 
 void replica::dump_cache() {
     splinterdb_print_cache(sm_->get_splinterdb_handle(), "cachedump");
+
+    ptr<nuraft::log_store> store = smgr_->load_log_store();
+    if (auto spl_store =
+            std::dynamic_pointer_cast<splinterdb_log_store>(store)) {
+        log_cache_stats stats = spl_store->get_cache_stats();
+        s_info << "log cache: entry hits " << stats.entry_hits_ << ", misses "
+               << stats.entry_misses_ << " (" << stats.entry_hit_rate()
+               << "), term hits " << stats.term_hits_ << ", misses "
+               << stats.term_misses_ << " (" << stats.term_hit_rate() << ")";
+    }
 }
 
 void replica::clear_cache() {
@@ -148,24 +298,308 @@ void replica::clear_cache() {
     splinterdb_clear_cache(sm_->get_splinterdb_handle());
 }
 
-std::pair<owned_slice, int32_t> replica::read(slice&& key) {
-    splinterdb_lookup_result result;
-    splinterdb_lookup_result_init(sm_->get_splinterdb_handle(), &result, 0,
-                                  NULL);
+namespace {
+
+/**
+ * The lookup result and buffer reused by every read on one thread.
+ */
+struct thread_lookup {
+    std::vector<char> buffer_ = std::vector<char>(INITIAL_LOOKUP_BUFFER_SIZE);
+    splinterdb_lookup_result result_;
+    bool initialized_ = false;
+
+    ~thread_lookup() {
+        if (initialized_) {
+            splinterdb_lookup_result_deinit(&result_);
+        }
+    }
+};
+
+}  // namespace
+
+int32_t replica::read(slice key, slice& value) {
+    thread_local thread_lookup lookup;
+
+    if (lookup.initialized_) {
+        // Releases the value of the previous read, if SplinterDB had to
+        // allocate room for it.
+        splinterdb_lookup_result_deinit(&lookup.result_);
+    }
+
+    splinterdb_lookup_result_init(sm_->get_splinterdb_handle(),
+                                  &lookup.result_, lookup.buffer_.size(),
+                                  lookup.buffer_.data());
+    lookup.initialized_ = true;
 
-    int rc = splinterdb_lookup(sm_->get_splinterdb_handle(),
-                               std::forward<slice>(key), &result);
+    stored_key stored(key);
+    int rc = splinterdb_lookup(sm_->get_splinterdb_handle(), stored.get(),
+                               &lookup.result_);
     if (rc) {
-        return {owned_slice{}, rc};
+        return rc;
     }
 
-    slice value;
-    rc = splinterdb_lookup_result_value(&result, &value);
+    rc = splinterdb_lookup_result_value(&lookup.result_, &value);
     if (rc) {
-        return {owned_slice{}, rc};
+        return rc;
+    }
+
+    // Make room for values of this size on the next read, within reason.
+    size_t length = slice_length(value);
+    if (length > lookup.buffer_.size() && length <= MAX_LOOKUP_BUFFER_SIZE) {
+        lookup.buffer_.resize(length);
+    }
+
+    return 0;
+}
+
+cb_func::ReturnCode replica::on_raft_event(cb_func::Type type,
+                                           cb_func::Param* param) {
+    switch (type) {
+        case cb_func::RequestAppendEntries: {
+            std::lock_guard<std::mutex> lk(contact_lock_);
+            peer_contact& contact = peer_contacts_[param->peerId];
+            if (contact.unacked_since_us_ == 0) {
+                contact.unacked_since_us_ = clock_us();
+            }
+            break;
+        }
+        case cb_func::GotAppendEntryRespFromPeer: {
+            std::lock_guard<std::mutex> lk(contact_lock_);
+            peer_contact& contact = peer_contacts_[param->peerId];
+            if (contact.unacked_since_us_ != 0) {
+                contact.acked_sent_us_ = contact.unacked_since_us_;
+                contact.unacked_since_us_ = 0;
+            }
+            break;
+        }
+        case cb_func::BecomeLeader:
+        case cb_func::BecomeFollower: {
+            // Acknowledgements from an earlier term prove nothing now.
+            std::lock_guard<std::mutex> lk(contact_lock_);
+            peer_contacts_.clear();
+            break;
+        }
+        default:
+            break;
+    }
+
+    return cb_func::ReturnCode::Ok;
+}
+
+uint64_t replica::quorum_contact_us() {
+    std::vector<raft_server::peer_info> peers =
+        raft_instance_->get_peer_info_all();
+
+    // The leader always agrees with itself, so only `quorum - 1` peers need
+    // to have acknowledged.
+    size_t quorum = (peers.size() + 1) / 2 + 1;
+    if (quorum == 1) {
+        return clock_us();
+    }
+
+    std::vector<uint64_t> sent;
+    sent.reserve(peers.size());
+    {
+        std::lock_guard<std::mutex> lk(contact_lock_);
+        for (const auto& peer : peers) {
+            auto it = peer_contacts_.find(peer.id_);
+            sent.push_back(it == peer_contacts_.end()
+                               ? 0
+                               : it->second.acked_sent_us_);
+        }
     }
 
-    return {owned_slice(value), rc};
+    std::sort(sent.begin(), sent.end(), std::greater<uint64_t>());
+    return sent[quorum - 2];
+}
+
+int32_t replica::prepare_consistent_read(read_consistency consistency) {
+    if (consistency == read_consistency::STALE) {
+        return 0;
+    }
+
+    if (!raft_instance_->is_leader()) {
+        return cmd_result_code::NOT_LEADER;
+    }
+
+    uint64_t term = raft_instance_->get_term();
+    uint64_t start_us = clock_us();
+    Timer timer;
+
+    auto check = [&]() -> int32_t {
+        if (!raft_instance_->is_leader() ||
+            raft_instance_->get_term() != term) {
+            return cmd_result_code::NOT_LEADER;
+        } else if (timer.getTimeMs() >= config_.read_index_timeout_ms_) {
+            return cmd_result_code::TIMEOUT;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return 0;
+    };
+
+    // A new leader only knows everything its predecessors committed once an
+    // entry of its own term has committed (Raft dissertation, 6.4).
+    ptr<nuraft::log_store> log = smgr_->load_log_store();
+    uint64_t read_idx = raft_instance_->get_committed_log_idx();
+    while (log->term_at(read_idx) != term) {
+        if (int32_t rc = check()) {
+            return rc;
+        }
+        read_idx = raft_instance_->get_committed_log_idx();
+    }
+
+    bool lease_valid =
+        consistency == read_consistency::LEASE &&
+        clock_us() - quorum_contact_us() < config_.read_lease_ms_ * 1000;
+
+    if (!lease_valid) {
+        // Wait for a majority to acknowledge requests sent after the read
+        // started, which proves nobody else had become leader by then.
+        while (quorum_contact_us() < start_us) {
+            if (int32_t rc = check()) {
+                return rc;
+            }
+        }
+    }
+
+    if (!raft_instance_->is_leader() || raft_instance_->get_term() != term) {
+        return cmd_result_code::NOT_LEADER;
+    }
+
+    if (!sm_->wait_for_apply(read_idx, config_.read_index_timeout_ms_)) {
+        return cmd_result_code::TIMEOUT;
+    }
+
+    return 0;
+}
+
+int32_t replica::wait_for_applied(raft_log_index min_log_idx) {
+    if (!sm_->wait_for_apply(min_log_idx, config_.min_index_read_wait_ms_)) {
+        return cmd_result_code::TIMEOUT;
+    }
+
+    return 0;
+}
+
+bool replica::changed_keys(raft_log_index since_idx, size_t max_keys,
+                           std::vector<std::vector<uint8_t>>& keys,
+                           raft_log_index& through_idx) const {
+    return sm_->get_key_changes().changes_since(since_idx, max_keys, keys,
+                                                through_idx);
+}
+
+std::vector<rpc_read_result> replica::multi_read(
+    const std::vector<std::vector<uint8_t>>& keys) {
+    std::vector<rpc_read_result> results(keys.size());
+
+    auto read_range = [this, &keys, &results](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            slice value;
+            int32_t rc = read(slice_create(keys[i].size(), keys[i].data()),
+                              value);
+
+            if (rc == 0) {
+                results[i] = rpc_read_result{slice_to_vector(value), 0};
+            } else {
+                results[i] = rpc_read_result{std::vector<uint8_t>{}, rc};
+            }
+        }
+    };
+
+    if (!read_pool_ || keys.size() < config_.parallel_read_threshold_) {
+        read_range(0, keys.size());
+        return results;
+    }
+
+    // One contiguous range per worker, plus one for the calling thread.
+    size_t num_ranges = read_pool_->size() + 1;
+    size_t range_size = (keys.size() + num_ranges - 1) / num_ranges;
+
+    // The tasks use `read_range` and `results` on this stack, so every
+    // submitted one has to finish before we return, even by throwing.
+    struct wait_for_pending {
+        std::vector<std::future<void>>& pending_;
+
+        ~wait_for_pending() {
+            for (auto& range : pending_) {
+                if (range.valid()) {
+                    range.wait();
+                }
+            }
+        }
+    };
+
+    std::vector<std::future<void>> pending;
+    pending.reserve(num_ranges);
+    wait_for_pending guard{pending};
+
+    for (size_t begin = range_size; begin < keys.size(); begin += range_size) {
+        size_t end = std::min(begin + range_size, keys.size());
+
+        auto task = std::make_shared<std::packaged_task<void()>>(
+            [&read_range, begin, end] { read_range(begin, end); });
+        std::future<void> range = task->get_future();
+        read_pool_->submit([task] { (*task)(); });
+        pending.push_back(std::move(range));
+    }
+
+    read_range(0, range_size);
+
+    for (auto& range : pending) {
+        range.get();
+    }
+
+    return results;
+}
+
+int32_t replica::scan(slice start_key, slice end_key, size_t max_entries,
+                      size_t max_bytes, std::vector<rpc_kv_pair>& entries,
+                      std::vector<uint8_t>& next_key) {
+    const data_config* data_cfg = &config_.splinterdb_data_cfg_;
+    auto in_range = [&](slice key) {
+        return slice_length(end_key) == 0 ||
+               data_cfg->key_compare(data_cfg, key, end_key) < 0;
+    };
+
+    stored_key stored_start(start_key);
+    splinterdb_iterator* it = nullptr;
+    int rc = splinterdb_iterator_init(sm_->get_splinterdb_handle(), &it,
+                                      stored_start.get());
+    if (rc) {
+        return rc;
+    }
+
+    entries.clear();
+    next_key.clear();
+
+    size_t page_bytes = 0;
+    for (; splinterdb_iterator_valid(it); splinterdb_iterator_next(it)) {
+        slice stored, value;
+        splinterdb_iterator_get_current(it, &stored, &value);
+        if (is_reserved_key(stored)) {
+            continue;
+        }
+
+        slice key = client_key(stored);
+        if (!in_range(key)) {
+            break;
+        }
+
+        if (!entries.empty() &&
+            (entries.size() >= max_entries || page_bytes >= max_bytes)) {
+            next_key = slice_to_vector(key);
+            break;
+        }
+
+        page_bytes += slice_length(key) + slice_length(value);
+        entries.emplace_back(slice_to_vector(key), slice_to_vector(value));
+    }
+
+    rc = splinterdb_iterator_status(it);
+    splinterdb_iterator_deinit(it);
+
+    return rc;
 }
 
 std::pair<cmd_result_code, std::string> replica::add_server(
@@ -197,9 +631,151 @@ ptr<replica::raft_result> replica::append_log(const splinterdb_operation& op) {
         //   `append_entries` returns after getting a consensus,
         //   so that `ret` already has the result from state machine.
         return ret;
-    } else /* if (config_.return_method_ == raft_params::async_handler) */ {
-        throw std::runtime_error("async handler not implemented");
     }
+
+    // Async handler mode:
+    //   `append_entries` returns immediately, so wait for the handler
+    //   to be invoked after getting a consensus.
+    std::promise<void> done;
+    ret->when_ready([&done](raft_result&, ptr<std::exception>&) {
+        done.set_value();
+    });
+    done.get_future().wait();
+
+    return ret;
+}
+
+void replica::append_log(const splinterdb_operation& op,
+                         handle_commit_result handle_result) {
+    ptr<Timer> timer = cs_new<Timer>();
+
+    if (config_.group_commit_window_us_ == 0 ||
+        op.type() == splinterdb_operation::BATCH) {
+        ptr<raft_result> ret = raft_instance_->append_entries({op.serialize()});
+
+        // In blocking mode the result is already there and the handler runs
+        // right away; otherwise it runs once the log has been committed.
+        ret->when_ready(std::bind(handle_result, timer, std::placeholders::_1,
+                                  std::placeholders::_2));
+        return;
+    }
+
+    std::unique_lock<std::mutex> lk(group_lock_);
+    group_queue_.push_back(pending_write{&op, timer, std::move(handle_result)});
+
+    if (group_queue_.size() > 1) {
+        // Another handler is collecting this group and will replicate it.
+        if (group_queue_.size() >= config_.group_commit_max_ops_) {
+            group_full_cv_.notify_one();
+        }
+
+        return;
+    }
+
+    // First write of a new group: give concurrent handlers a short window to
+    // join, then replicate everything that was collected at once.
+    group_full_cv_.wait_for(
+        lk, std::chrono::microseconds(config_.group_commit_window_us_),
+        [this] {
+            return group_queue_.size() >= config_.group_commit_max_ops_;
+        });
+
+    std::vector<pending_write> group;
+    group.swap(group_queue_);
+    lk.unlock();
+
+    commit_group(std::move(group));
+}
+
+void replica::commit_group(std::vector<pending_write>&& group) {
+    if (group.size() == 1) {
+        pending_write& write = group.front();
+        ptr<raft_result> ret =
+            raft_instance_->append_entries({write.op_->serialize()});
+        ret->when_ready(std::bind(write.handle_result_, write.timer_,
+                                  std::placeholders::_1,
+                                  std::placeholders::_2));
+        return;
+    }
+
+    std::vector<const splinterdb_operation*> ops;
+    ops.reserve(group.size());
+    for (const auto& write : group) {
+        ops.push_back(write.op_);
+    }
+
+    ptr<raft_result> ret = nullptr;
+    try {
+        ret = raft_instance_->append_entries(
+            {splinterdb_operation::serialize_batch(ops)});
+    } catch (const std::exception& e) {
+        s_err << "group commit of " << group.size()
+              << " writes failed: " << e.what();
+    }
+
+    if (!ret) {
+        for (auto& write : group) {
+            raft_result write_result;
+            ptr<buffer> rc_buf = nullptr;
+            ptr<std::exception> err = nullptr;
+            write_result.set_result(rc_buf, err, cmd_result_code::FAILED);
+            write.handle_result_(write.timer_, write_result, err);
+        }
+        return;
+    }
+
+    auto writes =
+        std::make_shared<std::vector<pending_write>>(std::move(group));
+    ret->when_ready([this, writes](raft_result& result,
+                                   ptr<std::exception>& err) {
+        // The state machine answers a BATCH with the overall return code,
+        // the log number it was applied at, the number of sub-operations and
+        // then one return code per sub-operation.
+        ptr<buffer> batch_result = nullptr;
+        if (result.has_result()) {
+            batch_result = result.get();
+        }
+
+        std::vector<int32_t> ret_codes;
+        uint64_t log_idx = 0;
+        if (batch_result) {
+            buffer_serializer bs(batch_result);
+            bs.get_i32();
+            log_idx = bs.get_u64();
+
+            uint32_t num_ret_codes = bs.get_u32();
+            if (num_ret_codes == writes->size()) {
+                for (uint32_t i = 0; i < num_ret_codes; ++i) {
+                    ret_codes.push_back(bs.get_i32());
+                }
+            } else {
+                s_err << "group commit returned " << num_ret_codes
+                      << " results for " << writes->size() << " writes";
+            }
+        }
+
+        for (size_t i = 0; i < writes->size(); ++i) {
+            pending_write& write = (*writes)[i];
+
+            raft_result write_result;
+            if (result.get_accepted()) {
+                write_result.accept();
+            }
+
+            ptr<buffer> rc_buf = nullptr;
+            if (!ret_codes.empty()) {
+                rc_buf = buffer::alloc(sizeof(int32_t) + sizeof(uint64_t));
+                buffer_serializer rc_bs(rc_buf);
+                rc_bs.put_i32(ret_codes[i]);
+                rc_bs.put_u64(log_idx);
+            }
+
+            ptr<std::exception> write_err = err;
+            write_result.set_result(rc_buf, write_err,
+                                    result.get_result_code());
+            write.handle_result_(write.timer_, write_result, write_err);
+        }
+    });
 }
 
 }  // namespace replicated_splinterdb
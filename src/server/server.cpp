@@ -1,7 +1,10 @@
 #include "server/server.h"
 
+#include <algorithm>
+#include <future>
 #include <iostream>
 
+#include "bytes_view.h"
 #include "common/rpc.h"
 #include "common/types.h"
 #include "libnuraft/buffer_serializer.hxx"
@@ -13,6 +16,13 @@ using nuraft::cmd_result_code;
 using nuraft::ptr;
 using std::vector;
 
+// Upper bounds on a single scan page, regardless of what the client asks for.
+static constexpr uint32_t MAX_SCAN_PAGE_ENTRIES = 10000;
+static constexpr uint64_t MAX_SCAN_PAGE_BYTES = 4 * 1024 * 1024;
+
+// Upper bound on the number of changed keys sent in one response.
+static constexpr uint32_t MAX_CHANGED_KEYS = 64 * 1024;
+
 server::server(uint16_t client_port, uint16_t join_port,
                const replica_config& cfg)
     : replica_instance_{cfg}, client_srv_{client_port}, join_srv_{join_port} {
@@ -42,30 +52,64 @@ void server::run(uint64_t nthreads) {
     join_srv_.run();
 }
 
-static rpc_mutation_result extract_result(ptr<replica::raft_result> result) {
+static rpc_mutation_result extract_result(replica::raft_result& result) {
     int32_t spl_rc = 0;
     int32_t raft_rc = 999;
+    raft_log_index log_idx = 0;
 
-    if (!result->get_accepted()) {
+    if (!result.get_accepted()) {
         std::cout << "WARNING: log append failed." << std::endl;
-        raft_rc = result->get_result_code();
-    } else if (!result->has_result()) {
+        raft_rc = result.get_result_code();
+    } else if (!result.has_result()) {
         std::cout << "WARNING: SM did not yield result yet" << std::endl;
-        raft_rc = result->get_result_code();
+        raft_rc = result.get_result_code();
     } else {
-        raft_rc = result->get_result_code();
-        ptr<buffer> buf = result->get();
+        raft_rc = result.get_result_code();
+        ptr<buffer> buf = result.get();
 
         if (buf != nullptr) {
-            spl_rc = buf->get_int();
+            // Every result starts with the return code and the log number.
+            nuraft::buffer_serializer bs(buf);
+            spl_rc = bs.get_i32();
+            log_idx = bs.get_u64();
         } else {
             std::cout << "WARNING: GOT nullptr RESULT (raft_rc=" << raft_rc
-                      << ", " << result->get_result_str() << ")" << std::endl;
+                      << ", " << result.get_result_str() << ")" << std::endl;
         }
     }
 
-    return std::tuple<int32_t, int32_t, std::string>{spl_rc, raft_rc,
-                                                     result->get_result_str()};
+    return rpc_mutation_result{spl_rc, raft_rc, result.get_result_str(),
+                               log_idx};
+}
+
+// Encoded exactly like `rpc_read_result`, but straight from the lookup buffer
+// of the handling thread instead of through a vector.
+using rpc_read_view = std::tuple<bytes_view, splinterdb_return_code>;
+
+static rpc_read_view read_view(replica& replica_instance, bytes_view key) {
+    slice value;
+    int32_t rc = replica_instance.read(key.to_slice(), value);
+    if (rc != 0) {
+        return rpc_read_view{bytes_view{}, rc};
+    }
+
+    return rpc_read_view{bytes_view{value}, 0};
+}
+
+rpc_mutation_result server::replicate(const splinterdb_operation& op) {
+    // rpclib has no deferred responses: it sends the response once the
+    // handler returns, so the worker waits here for the commit in either
+    // return method.
+    std::promise<rpc_mutation_result> promise;
+    std::future<rpc_mutation_result> future = promise.get_future();
+
+    replica_instance_.append_log(
+        op, [&promise](ptr<Timer>, replica::raft_result& result,
+                       ptr<std::exception>&) {
+            promise.set_value(extract_result(result));
+        });
+
+    return future.get();
 }
 
 void server::initialize() {
@@ -129,45 +173,154 @@ void server::initialize() {
         }
     });
 
-    // std::vector<uint8_t> -> rpc_read_result
-    client_srv_.bind(RPC_SPLINTERDB_GET, [this](vector<uint8_t> key) {
-        slice key_slice = slice_create(key.size(), key.data());
-        auto [slice, rc] = replica_instance_.read(std::move(key_slice));
-
-        if (rc == 0) {
-            return rpc_read_result{owned_slice::take_data(std::move(slice)), 0};
-        } else {
-            return rpc_read_result{{}, rc};
+    // (std::vector<uint8_t>, uint64_t) -> rpc_read_result
+    client_srv_.bind(RPC_SPLINTERDB_GET, [this](bytes_view key,
+                                                raft_log_index min_log_idx) {
+        int32_t raft_rc = replica_instance_.wait_for_applied(min_log_idx);
+        if (raft_rc != 0) {
+            return rpc_read_view{bytes_view{}, raft_rc};
         }
+
+        return read_view(replica_instance_, key);
     });
 
+    // (std::vector<uint8_t>, uint8_t) -> rpc_read_result
+    client_srv_.bind(
+        RPC_SPLINTERDB_CONSISTENT_GET,
+        [this](bytes_view key, uint8_t consistency) {
+            if (consistency > static_cast<uint8_t>(read_consistency::LEASE)) {
+                rpc::this_handler().respond_error(
+                    std::make_tuple("Invalid read consistency"));
+                return rpc_read_view{};
+            }
+
+            int32_t rc = replica_instance_.prepare_consistent_read(
+                static_cast<read_consistency>(consistency));
+            if (rc != 0) {
+                return rpc_read_view{bytes_view{}, rc};
+            }
+
+            return read_view(replica_instance_, key);
+        });
+
+    // (std::vector<std::vector<uint8_t>>, uint64_t)
+    //   -> std::vector<rpc_read_result>
+    client_srv_.bind(
+        RPC_SPLINTERDB_MULTI_GET,
+        [this](vector<vector<uint8_t>> keys, raft_log_index min_log_idx) {
+            int32_t raft_rc = replica_instance_.wait_for_applied(min_log_idx);
+            if (raft_rc != 0) {
+                return vector<rpc_read_result>(
+                    keys.size(), rpc_read_result{vector<uint8_t>{}, raft_rc});
+            }
+
+            return replica_instance_.multi_read(keys);
+        });
+
+    // (std::vector<uint8_t>, std::vector<uint8_t>, uint32_t,
+    //  std::vector<uint8_t>, uint64_t, uint64_t) -> rpc_scan_result
+    client_srv_.bind(
+        RPC_SPLINTERDB_SCAN,
+        [this](vector<uint8_t> start_key, vector<uint8_t> end_key,
+               uint32_t limit, vector<uint8_t> continuation,
+               uint64_t max_bytes, raft_log_index min_log_idx) {
+            int32_t raft_rc = replica_instance_.wait_for_applied(min_log_idx);
+            if (raft_rc != 0) {
+                return rpc_scan_result{{}, {}, raft_rc};
+            }
+
+            // A non-empty continuation is the first key of the next page.
+            const vector<uint8_t>& from =
+                continuation.empty() ? start_key : continuation;
+
+            vector<rpc_kv_pair> entries;
+            vector<uint8_t> next_key;
+            int32_t rc = replica_instance_.scan(
+                slice_create(from.size(), from.data()),
+                slice_create(end_key.size(), end_key.data()),
+                std::clamp<uint32_t>(limit, 1, MAX_SCAN_PAGE_ENTRIES),
+                std::clamp<uint64_t>(max_bytes, 1, MAX_SCAN_PAGE_BYTES),
+                entries, next_key);
+
+            if (rc != 0) {
+                return rpc_scan_result{{}, {}, rc};
+            }
+
+            return rpc_scan_result{std::move(entries), std::move(next_key), 0};
+        });
+
+    // (uint64_t, uint32_t) -> rpc_changes_result
+    client_srv_.bind(
+        RPC_SPLINTERDB_GET_CHANGES,
+        [this](raft_log_index since_idx, uint32_t max_keys) {
+            vector<vector<uint8_t>> keys;
+            raft_log_index through_idx = 0;
+            bool complete = replica_instance_.changed_keys(
+                since_idx, std::clamp<uint32_t>(max_keys, 1, MAX_CHANGED_KEYS),
+                keys, through_idx);
+
+            return rpc_changes_result{std::move(keys), through_idx, complete};
+        });
+
     // (std::vector<uint8_t>, std::vector<uint8_t>) -> rpc_mutation_result
     client_srv_.bind(
         RPC_SPLINTERDB_PUT, [this](vector<uint8_t> key, vector<uint8_t> value) {
             splinterdb_operation op{splinterdb_operation::make_put(
                 std::move(key), std::move(value))};
-            ptr<replica::raft_result> result = replica_instance_.append_log(op);
-
-            return extract_result(result);
+            return replicate(op);
         });
 
     // std::vector<uint8_t> -> rpc_mutation_result
     client_srv_.bind(RPC_SPLINTERDB_DELETE, [this](vector<uint8_t> key) {
         splinterdb_operation op{
             splinterdb_operation::make_delete(std::move(key))};
-        ptr<replica::raft_result> result = replica_instance_.append_log(op);
-
-        return extract_result(result);
+        return replicate(op);
     });
 
+    // (std::vector<std::vector<uint8_t>>, std::vector<std::vector<uint8_t>>)
+    //   -> rpc_mutation_result
+    client_srv_.bind(
+        RPC_SPLINTERDB_MULTI_PUT,
+        [this](vector<vector<uint8_t>> keys, vector<vector<uint8_t>> values) {
+            if (keys.size() != values.size()) {
+                rpc::this_handler().respond_error(
+                    std::make_tuple("Number of keys and values must match"));
+                return rpc_mutation_result{};
+            }
+
+            vector<splinterdb_operation> ops;
+            ops.reserve(keys.size());
+            for (size_t i = 0; i < keys.size(); ++i) {
+                ops.push_back(splinterdb_operation::make_put(
+                    std::move(keys[i]), std::move(values[i])));
+            }
+
+            splinterdb_operation op{
+                splinterdb_operation::make_batch(std::move(ops))};
+            return replicate(op);
+        });
+
+    // std::vector<std::vector<uint8_t>> -> rpc_mutation_result
+    client_srv_.bind(
+        RPC_SPLINTERDB_MULTI_DELETE, [this](vector<vector<uint8_t>> keys) {
+            vector<splinterdb_operation> ops;
+            ops.reserve(keys.size());
+            for (auto& key : keys) {
+                ops.push_back(
+                    splinterdb_operation::make_delete(std::move(key)));
+            }
+
+            splinterdb_operation op{
+                splinterdb_operation::make_batch(std::move(ops))};
+            return replicate(op);
+        });
+
     // (std::vector<uint8_t>, std::vector<uint8_t>) -> rpc_mutation_result
     client_srv_.bind(RPC_SPLINTERDB_UPDATE, [this](vector<uint8_t> key,
                                                    vector<uint8_t> value) {
         splinterdb_operation op{
             splinterdb_operation::make_put(std::move(key), std::move(value))};
-        ptr<replica::raft_result> result = replica_instance_.append_log(op);
-
-        return extract_result(result);
+        return replicate(op);
     });
 }
 
@@ -0,0 +1,138 @@
+#include "snapshot_file.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+
+namespace replicated_splinterdb {
+
+using nuraft::buffer;
+using nuraft::ptr;
+
+static std::runtime_error io_error(const std::string& what,
+                                   const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + strerror(errno));
+}
+
+/**
+ * @return `false` if `fd` ended before `len` bytes were read.
+ */
+static bool pread_fully(int fd, void* buf, size_t len, uint64_t offset,
+                        const std::string& path) {
+    auto* out = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t n = pread(fd, out, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            throw io_error("Failed to read", path);
+        } else if (n == 0) {
+            return false;
+        }
+
+        out += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+static void write_fully(int fd, const void* buf, size_t len,
+                        const std::string& path) {
+    auto* in = static_cast<const char*>(buf);
+    while (len > 0) {
+        ssize_t n = write(fd, in, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            throw io_error("Failed to write", path);
+        }
+
+        in += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+snapshot_file_writer::snapshot_file_writer(const std::string& path)
+    : path_(path), tmp_path_(path + ".tmp"), fd_(-1) {
+    fd_ = open(tmp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        throw io_error("Failed to create", tmp_path_);
+    }
+}
+
+snapshot_file_writer::~snapshot_file_writer() {
+    if (fd_ >= 0) {
+        close(fd_);
+        unlink(tmp_path_.c_str());
+    }
+}
+
+void snapshot_file_writer::append(const nuraft::byte* data, size_t size) {
+    uint64_t header = size;
+    write_fully(fd_, &header, sizeof(header), tmp_path_);
+    write_fully(fd_, data, size, tmp_path_);
+}
+
+void snapshot_file_writer::commit() {
+    if (fsync(fd_) != 0) {
+        throw io_error("Failed to sync", tmp_path_);
+    }
+    close(fd_);
+    fd_ = -1;
+
+    if (rename(tmp_path_.c_str(), path_.c_str()) != 0) {
+        unlink(tmp_path_.c_str());
+        throw io_error("Failed to rename", tmp_path_);
+    }
+
+    // Make the rename itself durable.
+    std::string dir = std::filesystem::path(path_).parent_path().string();
+    int dir_fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+}
+
+ptr<buffer> read_snapshot_chunk(const std::string& path, uint64_t offset,
+                                uint64_t& next_offset, bool& is_last) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    ptr<buffer> chunk = nullptr;
+    try {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            throw io_error("Failed to stat", path);
+        }
+        auto file_size = static_cast<uint64_t>(st.st_size);
+
+        uint64_t size = 0;
+        if (pread_fully(fd, &size, sizeof(size), offset, path) &&
+            size <= file_size - offset - sizeof(size)) {
+            chunk = buffer::alloc(static_cast<size_t>(size));
+            if (pread_fully(fd, chunk->data_begin(), chunk->size(),
+                            offset + sizeof(size), path)) {
+                next_offset = offset + sizeof(size) + size;
+                is_last = next_offset >= file_size;
+                chunk->pos(0);
+            } else {
+                chunk = nullptr;
+            }
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+
+    close(fd);
+    return chunk;
+}
+
+}  // namespace replicated_splinterdb
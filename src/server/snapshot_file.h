@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "libnuraft/nuraft.hxx"
+
+namespace replicated_splinterdb {
+
+/**
+ * Writes a snapshot file: a frozen copy of the client data as of a snapshot,
+ * kept next to the SplinterDB instance. SplinterDB cannot hand out a
+ * point-in-time view of its own, so snapshots are sent to followers, and
+ * restored after a crash, from these files.
+ *
+ * A snapshot file is a sequence of the chunks sent to followers as snapshot
+ * objects, each preceded by its size. It is written aside and only renamed
+ * into place by `commit`, so a snapshot file is always complete.
+ */
+class snapshot_file_writer {
+  public:
+    explicit snapshot_file_writer(const std::string& path);
+
+    /**
+     * Remove the file, unless it has been committed.
+     */
+    ~snapshot_file_writer();
+
+    __nocopy__(snapshot_file_writer);
+
+    /**
+     * Append the chunk `data` of `size` bytes.
+     */
+    void append(const nuraft::byte* data, size_t size);
+
+    /**
+     * Sync the file and move it into place.
+     */
+    void commit();
+
+  private:
+    const std::string path_;
+    const std::string tmp_path_;
+    int fd_;
+};
+
+/**
+ * Read the chunk at `offset` of the snapshot file `path`.
+ *
+ * @param next_offset Set to where the next chunk starts.
+ * @param is_last Set if there is no next chunk.
+ * @return The chunk, or null if the file or the chunk are missing.
+ */
+nuraft::ptr<nuraft::buffer> read_snapshot_chunk(const std::string& path,
+                                                uint64_t offset,
+                                                uint64_t& next_offset,
+                                                bool& is_last);
+
+}  // namespace replicated_splinterdb
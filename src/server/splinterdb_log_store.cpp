@@ -1,9 +1,12 @@
 #include "splinterdb_log_store.h"
 
+#include <algorithm>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
-#include <numeric>
 
+#include "common/crc32c.h"
+#include "log_pack.h"
 #include "server/splinterdb_operation.h"
 
 namespace replicated_splinterdb {
@@ -25,88 +28,372 @@ extern "C" int log_key_compare(const data_config* cfg, slice key1, slice key2) {
     }
 }
 
-static slice log_key_create(const uint64_t& index) {
-    return slice_create(sizeof(uint64_t), &index);
-}
+/**
+ * The SplinterDB key of a log entry. A dedicated instance keys entries by
+ * their native index, ordered by `log_key_compare`. In an instance shared
+ * with the state machine, the key is the log partition prefix followed by the
+ * big-endian index, so that entries sort bytewise among the reserved keys.
+ */
+class log_key {
+  public:
+    log_key(uint64_t index, bool shared) : size_(0) {
+        if (shared) {
+            memcpy(data_, RESERVED_KEY_PREFIX, RESERVED_KEY_PREFIX_SIZE);
+            size_ = RESERVED_KEY_PREFIX_SIZE;
+            data_[size_++] = LOG_PARTITION;
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                data_[size_++] = static_cast<char>(index >> shift);
+            }
+        } else {
+            memcpy(data_, &index, sizeof(index));
+            size_ = sizeof(index);
+        }
+    }
+
+    slice get() const { return slice_create(size_, data_); }
+
+    /**
+     * Decode the index of a key read back from SplinterDB.
+     *
+     * @return `false` if `key` is not a log key.
+     */
+    static bool decode(slice key, bool shared, uint64_t& index) {
+        const char* data = static_cast<const char*>(slice_data(key));
+        if (!shared) {
+            if (slice_length(key) != sizeof(index)) {
+                return false;
+            }
+            memcpy(&index, data, sizeof(index));
+            return true;
+        }
 
-static ptr<buffer> slice_to_buffer(const slice& value) {
-    ptr<buffer> buf = buffer::alloc(slice_length(value));
-    buf->put_raw(reinterpret_cast<const nuraft::byte*>(slice_data(value)),
-                 slice_length(value));
+        if (slice_length(key) != SHARED_SIZE ||
+            memcmp(data, RESERVED_KEY_PREFIX, RESERVED_KEY_PREFIX_SIZE) != 0 ||
+            data[RESERVED_KEY_PREFIX_SIZE] != LOG_PARTITION) {
+            return false;
+        }
+
+        index = 0;
+        for (size_t i = RESERVED_KEY_PREFIX_SIZE + 1; i < SHARED_SIZE; ++i) {
+            index = (index << 8) | static_cast<unsigned char>(data[i]);
+        }
+        return true;
+    }
+
+    static constexpr size_t SHARED_SIZE = splinterdb_log_store::SHARED_KEY_SIZE;
+
+  private:
+    char data_[SHARED_SIZE];
+    size_t size_;
+};
+
+// Log indexes start at 1, so key 0 is free to hold the index of the first
+// entry, which is all that is needed to find the bounds of the log again.
+static constexpr uint64_t START_INDEX_KEY = 0;
+
+static ptr<buffer> bytes_to_buffer(const nuraft::byte* data, size_t size) {
+    ptr<buffer> buf = buffer::alloc(size);
+    buf->put_raw(data, size);
+    buf->pos(0);
     return buf;
 }
 
+/**
+ * @return `sync`, if it asks for no durability, which is all a SplinterDB log
+ *         store can offer.
+ * @throws std::invalid_argument Otherwise.
+ */
+static const log_sync_options& unsynced(const log_sync_options& sync) {
+    if (sync.durability_ != log_durability::NONE) {
+        throw std::invalid_argument(
+            "a SplinterDB log store cannot sync its entries; its log "
+            "durability must be NONE");
+    }
+    return sync;
+}
+
+/**
+ * Check a stored value, which is the CRC32C of the serialized entry followed
+ * by the entry itself.
+ *
+ * @return The serialized entry, pointing into `value`.
+ * @throws std::runtime_error If the entry does not match its checksum.
+ */
+static const nuraft::byte* checked_entry(slice value, uint64_t index,
+                                         uint32_t& size) {
+    auto* data = static_cast<const nuraft::byte*>(slice_data(value));
+    if (slice_length(value) <= LOG_CHECKSUM_SIZE) {
+        throw std::runtime_error("Truncated log entry at index " +
+                                 std::to_string(index));
+    }
+
+    size = static_cast<uint32_t>(slice_length(value) - LOG_CHECKSUM_SIZE);
+    const nuraft::byte* entry = data + LOG_CHECKSUM_SIZE;
+    if (crc32c(entry, size) != get_log_checksum(data)) {
+        throw std::runtime_error("Corrupted log entry at index " +
+                                 std::to_string(index));
+    }
+    return entry;
+}
+
+/**
+ * Visit the stored entries with indexes in [start, end) in order, with a
+ * single iterator pass. `visit(index, value)` returns `false` to stop early;
+ * `value` is only valid during the call.
+ *
+ * @return `false` if the iterator failed or an index in the range is missing
+ *         before the visitor stopped.
+ */
+template <typename Visitor>
+static bool scan_log(const splinterdb* spl, bool shared, uint64_t start,
+                     uint64_t end, Visitor&& visit) {
+    if (start >= end) {
+        return true;
+    }
+
+    splinterdb_iterator* it = nullptr;
+    log_key start_key(start, shared);
+    if (splinterdb_iterator_init(spl, &it, start_key.get()) != 0) {
+        return false;
+    }
+
+    uint64_t expected = start;
+    bool stopped = false;
+    for (; expected < end && splinterdb_iterator_valid(it);
+         splinterdb_iterator_next(it)) {
+        slice key, value;
+        splinterdb_iterator_get_current(it, &key, &value);
+
+        uint64_t index;
+        if (!log_key::decode(key, shared, index) || index != expected) {
+            // A hole in the log, or past the log partition.
+            break;
+        }
+
+        ++expected;
+        if (!visit(index, value)) {
+            stopped = true;
+            break;
+        }
+    }
+
+    bool ok =
+        splinterdb_iterator_status(it) == 0 && (stopped || expected == end);
+    splinterdb_iterator_deinit(it);
+    return ok;
+}
+
 splinterdb_log_store::splinterdb_log_store(const std::string& file_name,
+                                           const log_sync_options& sync,
+                                           size_t tail_cache_entries,
                                            uint64_t disk_size,
                                            uint64_t cache_size)
-    : spl_(nullptr), start_idx_(1), last_idx_(0) {
+    : file_name_(file_name),
+      shared_(false),
+      owner_(),
+      spl_(nullptr),
+      start_idx_(1),
+      last_idx_(0),
+      syncer_(unsynced(sync), [] { return true; }),
+      terms_(),
+      tail_(tail_cache_entries),
+      cache_stats_(),
+      cache_lock_() {
     default_data_config_init(sizeof(uint64_t), &splinter_data_cfg_);
     splinter_data_cfg_.key_compare = log_key_compare;
 
     memset(&splinterdb_cfg_, 0, sizeof(splinterdb_cfg_));
-    splinterdb_cfg_.filename = file_name.c_str();
+    splinterdb_cfg_.filename = file_name_.c_str();
     splinterdb_cfg_.disk_size = disk_size;
     splinterdb_cfg_.cache_size = cache_size;
     splinterdb_cfg_.data_cfg = &splinter_data_cfg_;
 
-    int rc = splinterdb_create(&splinterdb_cfg_, &spl_);
+    bool exists = std::filesystem::exists(file_name_);
+    int rc = exists ? splinterdb_open(&splinterdb_cfg_, &spl_)
+                    : splinterdb_create(&splinterdb_cfg_, &spl_);
     if (rc != 0) {
-        throw std::runtime_error("Failed to create SplinterDB log instance");
+        throw std::runtime_error("Failed to " +
+                                 std::string(exists ? "open" : "create") +
+                                 " SplinterDB log instance");
     }
-}
 
-splinterdb_log_store::~splinterdb_log_store() { splinterdb_close(&spl_); }
+    if (exists) {
+        recover();
+    }
+}
 
-uint64_t splinterdb_log_store::next_slot() const { return last_idx_ + 1; }
+splinterdb_log_store::splinterdb_log_store(splinterdb* spl,
+                                           std::shared_ptr<void> owner,
+                                           const std::string& file_name,
+                                           const log_sync_options& sync,
+                                           size_t tail_cache_entries)
+    : file_name_(file_name),
+      shared_(true),
+      owner_(std::move(owner)),
+      spl_(spl),
+      start_idx_(1),
+      last_idx_(0),
+      syncer_(unsynced(sync), [] { return true; }),
+      terms_(),
+      tail_(tail_cache_entries),
+      cache_stats_(),
+      cache_lock_() {
+    memset(&splinter_data_cfg_, 0, sizeof(splinter_data_cfg_));
+    memset(&splinterdb_cfg_, 0, sizeof(splinterdb_cfg_));
 
-uint64_t splinterdb_log_store::start_index() const { return start_idx_; }
+    // The instance may hold a log from a previous run, or only client data.
+    recover();
+}
 
-ptr<log_entry> splinterdb_log_store::last_entry() const {
+bool splinterdb_log_store::has_entry(uint64_t index) const {
     splinterdb_lookup_result result;
     splinterdb_lookup_result_init(spl_, &result, 0, NULL);
 
-    uint64_t index = last_idx_;
-    int rc = splinterdb_lookup(spl_, log_key_create(index), &result);
-    if (rc == 0) {
+    log_key key(index, shared_);
+    bool found = splinterdb_lookup(spl_, key.get(), &result) == 0 &&
+                 splinterdb_lookup_found(&result);
+
+    splinterdb_lookup_result_deinit(&result);
+    return found;
+}
+
+void splinterdb_log_store::recover() {
+    uint64_t start = 1;
+
+    splinterdb_lookup_result result;
+    splinterdb_lookup_result_init(spl_, &result, 0, NULL);
+    log_key key(START_INDEX_KEY, shared_);
+    if (splinterdb_lookup(spl_, key.get(), &result) == 0) {
         slice value;
-        rc = splinterdb_lookup_result_value(&result, &value);
-        if (rc == 0) {
-            ptr<buffer> buf = slice_to_buffer(value);
+        if (splinterdb_lookup_result_value(&result, &value) == 0 &&
+            slice_length(value) == sizeof(uint64_t)) {
+            memcpy(&start, slice_data(value), sizeof(start));
+        }
+    }
+    splinterdb_lookup_result_deinit(&result);
+
+    // Entries are contiguous from `start`, so the last one can be found with
+    // a galloping search instead of a scan over the whole log.
+    uint64_t last = start - 1;
+    if (has_entry(start)) {
+        uint64_t step = 1;
+        uint64_t hi = start + step;
+        last = start;
+        while (has_entry(hi)) {
+            last = hi;
+            step *= 2;
+            hi = last + step;
+        }
 
-            return log_entry::deserialize(*buf);
+        // The last entry is in [last, hi).
+        while (hi - last > 1) {
+            uint64_t mid = last + (hi - last) / 2;
+            if (has_entry(mid)) {
+                last = mid;
+            } else {
+                hi = mid;
+            }
         }
     }
 
-    return nuraft::cs_new<log_entry>(0, nullptr);
+    start_idx_ = start;
+    last_idx_ = last;
+    syncer_.reset(last);
+
+    terms_.clear();
+    if (last >= start) {
+        recover_terms(start, stored_term(start), last, stored_term(last));
+    }
+}
+
+void splinterdb_log_store::recover_terms(uint64_t first, uint64_t first_term,
+                                         uint64_t last, uint64_t last_term) {
+    // Terms never decrease along the log, so a range whose ends share a term
+    // is a single run, and the runs are found with a few lookups per term
+    // rather than by reading every entry.
+    if (first_term == last_term) {
+        terms_.append_run(first, last, first_term);
+        return;
+    }
+
+    if (last == first + 1) {
+        terms_.append(first, first_term);
+        terms_.append(last, last_term);
+        return;
+    }
+
+    uint64_t mid = first + (last - first) / 2;
+    recover_terms(first, first_term, mid, stored_term(mid));
+    recover_terms(mid + 1, stored_term(mid + 1), last, last_term);
+}
+
+uint64_t splinterdb_log_store::stored_term(uint64_t index) const {
+    ptr<log_entry> entry = read_entry(index);
+    if (!entry) {
+        throw std::runtime_error("Missing log entry at index " +
+                                 std::to_string(index));
+    }
+    return entry->get_term();
+}
+
+splinterdb_log_store::~splinterdb_log_store() {
+    syncer_.stop();
+    if (!shared_) {
+        splinterdb_close(&spl_);
+    }
+}
+
+uint64_t splinterdb_log_store::next_slot() const { return last_idx_ + 1; }
+
+uint64_t splinterdb_log_store::start_index() const { return start_idx_; }
+
+ptr<log_entry> splinterdb_log_store::last_entry() const {
+    ptr<log_entry> entry = read_entry(last_idx_);
+    return entry ? entry : nuraft::cs_new<log_entry>(0, nullptr);
 }
 
 uint64_t splinterdb_log_store::append(ptr<log_entry>& entry) {
-    uint64_t index = last_idx_++;
-    slice key = log_key_create(index);
+    uint64_t index = ++last_idx_;
+    insert_entry(index, *entry, 0);
+    return index;
+}
+
+void splinterdb_log_store::insert_entry(uint64_t index, log_entry& entry,
+                                        uint64_t truncated_from) {
+    log_key key(index, shared_);
 
-    ptr<buffer> buf = entry->serialize();
-    slice serialized_log = slice_create(buf->size(), buf->data_begin());
+    ptr<buffer> buf = entry.serialize();
+    std::vector<nuraft::byte> value(LOG_CHECKSUM_SIZE + buf->size());
+    put_log_checksum(value.data(), crc32c(buf->data_begin(), buf->size()));
+    memcpy(value.data() + LOG_CHECKSUM_SIZE, buf->data_begin(), buf->size());
 
-    int rc = splinterdb_insert(spl_, key, serialized_log);
+    int rc = splinterdb_insert(spl_, key.get(),
+                               slice_create(value.size(), value.data()));
     if (rc != 0) {
         throw std::runtime_error("Failed to append log entry");
     }
 
-    return index;
+    {
+        std::lock_guard<std::mutex> l(cache_lock_);
+        if (truncated_from > 0) {
+            terms_.truncate(truncated_from);
+            tail_.truncate(truncated_from);
+        }
+        terms_.append(index, entry.get_term());
+        tail_.put(index, buf);
+    }
+
+    sync_append(syncer_.written(buf->size(), index, truncated_from));
 }
 
 void splinterdb_log_store::write_at(uint64_t index, ptr<log_entry>& entry) {
     uint64_t old_last_idx = last_idx_;
-    last_idx_ = index - 1;
-
-    std::vector<uint64_t> to_delete(old_last_idx - index + 1);
-    std::iota(std::begin(to_delete), std::end(to_delete), index);
+    last_idx_ = index;
 
-    for (const uint64_t& key : to_delete) {
-        splinterdb_delete(spl_, log_key_create(key));
-    }
+    // `index` itself is overwritten below.
+    delete_range(index + 1, old_last_idx + 1);
 
-    append(entry);
+    insert_entry(index, *entry, index);
 }
 
 ptr<std::vector<ptr<log_entry>>> splinterdb_log_store::log_entries(
@@ -114,100 +401,140 @@ ptr<std::vector<ptr<log_entry>>> splinterdb_log_store::log_entries(
     ptr<std::vector<ptr<log_entry>>> ret =
         nuraft::cs_new<std::vector<ptr<log_entry>>>();
 
-    ret->resize(end - start);
-
-    for (uint64_t i = start; i < end; i++) {
-        splinterdb_lookup_result result;
-        splinterdb_lookup_result_init(spl_, &result, 0, NULL);
-
-        int rc = splinterdb_lookup(spl_, log_key_create(i), &result);
-        if (rc == 0) {
-            slice value;
-            rc = splinterdb_lookup_result_value(&result, &value);
-            if (rc == 0) {
-                ptr<buffer> buf = slice_to_buffer(value);
-                (*ret)[i - start] = log_entry::deserialize(*buf);
+    if (start < start_idx_ || end > last_idx_ + 1) {
+        return nullptr;
+    }
+    ret->reserve(end > start ? end - start : 0);
+
+    // Followers that keep up ask for the tail, which is usually cached;
+    // whatever is not gets read with a single scan.
+    uint64_t next = start;
+    {
+        std::lock_guard<std::mutex> l(cache_lock_);
+        for (; next < end; ++next) {
+            ptr<buffer> buf = tail_.get(next);
+            if (!buf) {
+                break;
             }
+            ret->push_back(log_entry::deserialize(*buf));
         }
-
-        if (rc != 0) {
-            return nullptr;
-        }
+        cache_stats_.entry_hits_ += next - start;
+        cache_stats_.entry_misses_ += end - next;
     }
 
-    return ret;
+    bool ok =
+        scan_log(spl_, shared_, next, end, [&ret](uint64_t i, slice value) {
+            uint32_t size;
+            const nuraft::byte* data = checked_entry(value, i, size);
+            ptr<buffer> buf = bytes_to_buffer(data, size);
+            ret->push_back(log_entry::deserialize(*buf));
+            return true;
+        });
+
+    return ok ? ret : nullptr;
 }
 
 ptr<log_entry> splinterdb_log_store::entry_at(uint64_t index) {
+    return read_entry(index);
+}
+
+ptr<log_entry> splinterdb_log_store::read_entry(uint64_t index) const {
+    if (index < start_idx_ || index > last_idx_) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> l(cache_lock_);
+        ptr<buffer> buf = tail_.get(index);
+        if (buf) {
+            cache_stats_.entry_hits_++;
+            return log_entry::deserialize(*buf);
+        }
+        cache_stats_.entry_misses_++;
+    }
+
     splinterdb_lookup_result result;
     splinterdb_lookup_result_init(spl_, &result, 0, NULL);
 
-    slice key = log_key_create(index);
-
-    int rc = splinterdb_lookup(spl_, key, &result);
+    ptr<log_entry> entry = nullptr;
+    int rc = splinterdb_lookup(spl_, log_key(index, shared_).get(), &result);
     if (rc == 0) {
         slice value;
         rc = splinterdb_lookup_result_value(&result, &value);
         if (rc == 0) {
-            ptr<buffer> buf = slice_to_buffer(value);
-            return log_entry::deserialize(*buf);
+            uint32_t size;
+            const nuraft::byte* data;
+            try {
+                data = checked_entry(value, index, size);
+            } catch (...) {
+                splinterdb_lookup_result_deinit(&result);
+                throw;
+            }
+            entry = log_entry::deserialize(*bytes_to_buffer(data, size));
         }
     }
 
-    return nullptr;
+    splinterdb_lookup_result_deinit(&result);
+    return entry;
 }
 
 uint64_t splinterdb_log_store::term_at(uint64_t index) {
-    splinterdb_lookup_result result;
-    splinterdb_lookup_result_init(spl_, &result, 0, NULL);
-
     if (index >= next_slot()) {
         throw std::runtime_error("Log index out of range");
     } else if (index < start_index()) {
         return 0;
     }
 
-    int rc = splinterdb_lookup(spl_, log_key_create(index), &result);
-    if (rc == 0) {
-        slice value;
-        rc = splinterdb_lookup_result_value(&result, &value);
-        if (rc == 0) {
-            ptr<buffer> buf = slice_to_buffer(value);
-            ptr<log_entry> entry = log_entry::deserialize(*buf);
-            return entry->get_term();
+    {
+        std::lock_guard<std::mutex> l(cache_lock_);
+        std::optional<uint64_t> term = terms_.term_at(index);
+        if (term) {
+            cache_stats_.term_hits_++;
+            return *term;
         }
+        cache_stats_.term_misses_++;
     }
 
-    return 0;
+    ptr<log_entry> entry = read_entry(index);
+    return entry ? entry->get_term() : 0;
 }
 
 ptr<buffer> splinterdb_log_store::pack(uint64_t index, int32_t signed_cnt) {
-    uint64_t cnt = static_cast<uint64_t>(signed_cnt);
-    std::vector<ptr<buffer>> logs;
-    size_t size_total = 0;
-
-    for (uint64_t i = index; i < index + cnt; i++) {
-        ptr<log_entry> entry = entry_at(i);
-        if (entry == nullptr) {
-            break;
-        }
-
-        ptr<buffer> buf = entry->serialize();
-        size_total += buf->size();
-        logs.push_back(buf);
+    uint64_t cnt = signed_cnt > 0 ? static_cast<uint64_t>(signed_cnt) : 0;
+
+    // The stored values are checksummed, serialized entries already. A first
+    // pass sizes the pack, and a second one checks the entries and copies
+    // them straight into it.
+    uint64_t found = 0;
+    size_t bytes = 0;
+    scan_log(spl_, shared_, index, index + cnt,
+             [&found, &bytes](uint64_t, slice value) {
+                 found++;
+                 bytes += slice_length(value);
+                 return true;
+             });
+
+    if (bytes < found * LOG_CHECKSUM_SIZE) {
+        throw std::runtime_error("Truncated log entry in [" +
+                                 std::to_string(index) + ", " +
+                                 std::to_string(index + found) + ")");
     }
-
     ptr<buffer> ret =
-        buffer::alloc(sizeof(int32_t) + cnt * sizeof(int32_t) + size_total);
-
-    ret->pos(0);
-    ret->put((int32_t)signed_cnt);
-
-    for (const auto& buf : logs) {
-        ret->put((int32_t)buf->size());
-        ret->put(*buf);
+        log_pack_create(found, bytes - found * LOG_CHECKSUM_SIZE);
+
+    auto put = [&ret](uint64_t i, slice value) {
+        uint32_t size;
+        const nuraft::byte* entry = checked_entry(value, i, size);
+        log_pack_put(*ret, entry, size,
+                     get_log_checksum(entry - LOG_CHECKSUM_SIZE));
+        return true;
+    };
+    if (!scan_log(spl_, shared_, index, index + found, put)) {
+        throw std::runtime_error("Log changed while packing from index " +
+                                 std::to_string(index));
     }
 
+    ret->pos(0);
     return ret;
 }
 
@@ -219,43 +546,128 @@ void splinterdb_log_store::apply_pack(uint64_t index, buffer& pack) {
     }
     uint64_t cnt = static_cast<uint64_t>(signed_cnt);
 
+    // Check the whole pack before touching the log, so that a corrupted
+    // pack leaves it as it was.
+    std::vector<std::pair<const nuraft::byte*, uint32_t>> entries;
+    entries.reserve(cnt);
     for (uint64_t i = 0; i < cnt; ++i) {
-        uint64_t cur_index = index + i;
-        int32_t size = pack.get_int();
+        uint32_t size;
+        const nuraft::byte* data = log_pack_get(pack, size);
+        entries.emplace_back(data, size);
+    }
 
-        if (size <= 0) {
-            throw std::runtime_error("Invalid log entry size");
+    uint64_t old_last_idx = last_idx_;
+    if (index < start_idx_ || index > old_last_idx + 1) {
+        // The pack does not line up with what we have; start over from it.
+        // As in `compact`, the recorded start moves first, so that a crash
+        // halfway through leaves no hole in the log.
+        int rc =
+            splinterdb_insert(spl_, log_key(START_INDEX_KEY, shared_).get(),
+                              slice_create(sizeof(index), &index));
+        if (rc != 0) {
+            throw std::runtime_error("Failed to move the log start to index " +
+                                     std::to_string(index));
         }
 
-        ptr<buffer> buf = buffer::alloc(static_cast<size_t>(size));
-        pack.get(buf);
+        // Whatever the pack overwrites is left for the inserts below.
+        delete_range(start_idx_,
+                     std::min<uint64_t>(index, old_last_idx + 1));
+        start_idx_ = index;
+        last_idx_ = std::max<uint64_t>(index, old_last_idx + 1) - 1;
 
-        int rc =
-            splinterdb_insert(spl_, log_key_create(cur_index),
-                              slice_create(buf->size(), buf->data_begin()));
+        std::lock_guard<std::mutex> l(cache_lock_);
+        terms_.clear();
+        tail_.truncate(0);
+    } else {
+        std::lock_guard<std::mutex> l(cache_lock_);
+        terms_.truncate(index);
+        tail_.truncate(index);
+    }
+
+    size_t bytes = 0;
+    uint64_t cur_index = index;
+    for (const auto& [data, size] : entries) {
+        // Insert straight from the pack, where the checksum precedes the
+        // entry just like in the store; SplinterDB copies the value.
+        int rc = splinterdb_insert(
+            spl_, log_key(cur_index, shared_).get(),
+            slice_create(LOG_CHECKSUM_SIZE + size, data - LOG_CHECKSUM_SIZE));
         if (rc != 0) {
             throw std::runtime_error("Failed to append log entry at index " +
                                      std::to_string(cur_index));
         }
+        bytes += size;
+
+        std::lock_guard<std::mutex> l(cache_lock_);
+        terms_.append(cur_index, get_log_term(data, size));
+        tail_.put(cur_index, bytes_to_buffer(data, size));
+        ++cur_index;
     }
+
+    old_last_idx = last_idx_;
+    last_idx_ = index + cnt - 1;
+    delete_range(last_idx_ + 1, old_last_idx + 1);
+
+    sync_append(syncer_.written(bytes, last_idx_, index));
 }
 
 bool splinterdb_log_store::compact(uint64_t last_log_index) {
-    uint64_t start = start_idx_;
-    std::vector<uint64_t> to_delete(last_log_index - start + 1);
-    std::iota(std::begin(to_delete), std::end(to_delete), start);
+    if (last_log_index < start_idx_) {
+        return true;
+    }
 
-    for (const uint64_t& key : to_delete) {
-        splinterdb_delete(spl_, log_key_create(key));
+    // Move the recorded start first: after a crash halfway through, the
+    // leftovers below it are ignored rather than taken as a hole in the log.
+    uint64_t new_start = last_log_index + 1;
+    int rc = splinterdb_insert(spl_, log_key(START_INDEX_KEY, shared_).get(),
+                               slice_create(sizeof(new_start), &new_start));
+    if (rc != 0) {
+        return false;
     }
 
-    if (start_idx_ <= last_log_index) {
-        start_idx_ = last_log_index + 1;
+    // Entries past the end of the log were never stored.
+    uint64_t end = std::min<uint64_t>(last_log_index, last_idx_) + 1;
+    delete_range(start_idx_, end);
+
+    start_idx_ = last_log_index + 1;
+    if (last_idx_ < last_log_index) {
+        last_idx_ = last_log_index;
+    }
+    syncer_.compacted(last_log_index);
+
+    {
+        std::lock_guard<std::mutex> l(cache_lock_);
+        terms_.compact(last_log_index);
     }
 
     return true;
 }
 
-bool splinterdb_log_store::flush() { return true; }
+void splinterdb_log_store::delete_range(uint64_t start, uint64_t end) {
+    // SplinterDB deletes are blind: each one just queues a tombstone in the
+    // memtable, without looking the key up. Log keys are dense, so there is
+    // nothing to discover with an iterator either.
+    for (uint64_t index = start; index < end; ++index) {
+        splinterdb_delete(spl_, log_key(index, shared_).get());
+    }
+}
+
+log_cache_stats splinterdb_log_store::get_cache_stats() const {
+    std::lock_guard<std::mutex> l(cache_lock_);
+    return cache_stats_;
+}
+
+bool splinterdb_log_store::flush() { return syncer_.sync_all(); }
+
+uint64_t splinterdb_log_store::last_durable_index() {
+    return syncer_.durable_index();
+}
+
+void splinterdb_log_store::sync_append(uint64_t ticket) {
+    if (!syncer_.on_append(ticket)) {
+        throw std::runtime_error("Failed to sync SplinterDB log file " +
+                                 file_name_);
+    }
+}
 
 }  // namespace replicated_splinterdb
\ No newline at end of file
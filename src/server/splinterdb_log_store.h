@@ -2,22 +2,68 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
 
 #include "libnuraft/event_awaiter.hxx"
 #include "libnuraft/internal_timer.hxx"
 #include "libnuraft/log_store.hxx"
+#include "key_space.h"
+#include "log_cache.h"
+#include "log_syncer.h"
 #include "server/splinterdb_wrapper.h"
 
 namespace replicated_splinterdb {
 
 extern "C" int log_key_compare(const data_config* cfg, slice key1, slice key2);
 
+/**
+ * A Raft log store backed by SplinterDB, keyed by log index. The store either
+ * has an instance of its own, or keeps the log under the reserved log
+ * partition of the state machine's instance (see `key_space.h`).
+ *
+ * Appends are never synced: SplinterDB keeps recent writes in its memtable
+ * and has no call for writing them back, so syncing the device file would not
+ * make them durable. The store only accepts `log_durability::NONE`, and
+ * entries survive a restart only if SplinterDB wrote them out before it.
+ *
+ * An existing log file is reopened, and the bounds of the log recovered from
+ * it.
+ *
+ * Every entry is stored behind the CRC32C of its serialized form, which is
+ * checked whenever the entry is read from SplinterDB or packed.
+ *
+ * The terms of all entries are kept in memory in a `term_index`, and the
+ * most recent serialized entries in a `tail_cache`, so that looking up terms
+ * and replicating fresh entries does not go to SplinterDB.
+ */
 class splinterdb_log_store : public nuraft::log_store {
   public:
-    splinterdb_log_store(const std::string& file_name = "log.db",
-                         uint64_t disk_size = 1024 * 1024 * 1024,
-                         uint64_t cache_size = 64 * 1024 * 1024);
+    // Default number of recent entries kept in memory.
+    static constexpr size_t DEFAULT_TAIL_CACHE_ENTRIES = 4096;
+
+    // Size of a log key in a shared instance: the reserved prefix, the log
+    // partition and the big-endian index.
+    static constexpr size_t SHARED_KEY_SIZE =
+        RESERVED_KEY_PREFIX_SIZE + 1 + sizeof(uint64_t);
+
+    splinterdb_log_store(
+        const std::string& file_name = "log.db",
+        const log_sync_options& sync = {log_durability::NONE},
+        size_t tail_cache_entries = DEFAULT_TAIL_CACHE_ENTRIES,
+        uint64_t disk_size = 1024 * 1024 * 1024,
+        uint64_t cache_size = 64 * 1024 * 1024);
+
+    /**
+     * Keep the log in `spl`, an instance opened by someone else on
+     * `file_name` with a `partitioned_data_config`. `owner` keeps the
+     * instance open for as long as the store uses it.
+     */
+    splinterdb_log_store(
+        splinterdb* spl, std::shared_ptr<void> owner,
+        const std::string& file_name,
+        const log_sync_options& sync = {log_durability::NONE},
+        size_t tail_cache_entries = DEFAULT_TAIL_CACHE_ENTRIES);
 
     ~splinterdb_log_store();
 
@@ -128,17 +174,30 @@ class splinterdb_log_store : public nuraft::log_store {
     bool compact(uint64_t last_log_index) override;
 
     /**
-     * Synchronously flush all log entries in this log store to the backing
-     * storage so that all log entries are guaranteed to be durable upon process
-     * crash.
+     * Return right away: appends are never synced, so there is nothing to
+     * wait for (see above).
      *
-     * @return `true` on success.
+     * @return `true`.
      */
     bool flush() override;
 
+    /**
+     * The last log index written, since none is ever synced.
+     */
+    uint64_t last_durable_index() override;
+
     splinterdb* get_splinterdb_handle() { return spl_; }
 
+    log_cache_stats get_cache_stats() const;
+
   private:
+    const std::string file_name_;
+
+    // Set when the instance belongs to `owner_` rather than to the store.
+    const bool shared_;
+
+    std::shared_ptr<void> owner_;
+
     splinterdb* spl_;
 
     data_config splinter_data_cfg_;
@@ -154,6 +213,62 @@ class splinterdb_log_store : public nuraft::log_store {
      * The index of the last log.
      */
     std::atomic<uint64_t> last_idx_;
+
+    log_syncer syncer_;
+
+    term_index terms_;
+
+    tail_cache tail_;
+
+    mutable log_cache_stats cache_stats_;
+
+    // Protects `terms_`, `tail_` and `cache_stats_`.
+    mutable std::mutex cache_lock_;
+
+    /**
+     * Find the bounds of the log in a reopened file, and the terms of its
+     * entries.
+     */
+    void recover();
+
+    /**
+     * Record the terms of the entries from `first` to `last` in `terms_`,
+     * given the terms of both ends.
+     */
+    void recover_terms(uint64_t first, uint64_t first_term, uint64_t last,
+                       uint64_t last_term);
+
+    /**
+     * @return The term of the stored entry at `index`.
+     * @throws std::runtime_error If there is no such entry.
+     */
+    uint64_t stored_term(uint64_t index) const;
+
+    bool has_entry(uint64_t index) const;
+
+    /**
+     * Read the entry at `index` from `tail_`, or from SplinterDB on a miss.
+     *
+     * @return The entry, or null if it is not stored.
+     */
+    nuraft::ptr<nuraft::log_entry> read_entry(uint64_t index) const;
+
+    /**
+     * Delete the entries with indexes in [start, end).
+     */
+    void delete_range(uint64_t start, uint64_t end);
+
+    /**
+     * Store `entry` at `index` and report the write to `syncer_`.
+     */
+    void insert_entry(uint64_t index, nuraft::log_entry& entry,
+                      uint64_t truncated_from);
+
+    /**
+     * Wait for the write behind `ticket` to be synced, if the durability mode
+     * asks for it.
+     */
+    void sync_append(uint64_t ticket);
 };
 
 }  // namespace replicated_splinterdb
@@ -8,22 +8,53 @@ using nuraft::buffer;
 using nuraft::buffer_serializer;
 using nuraft::ptr;
 
+static bool has_value(splinterdb_operation::splinterdb_operation_type type) {
+    return type == splinterdb_operation::PUT ||
+           type == splinterdb_operation::UPDATE;
+}
+
 ptr<buffer> splinterdb_operation::serialize() const {
-    size_t buffer_size = sizeof(type_) + key_.serialized_size();
+    ptr<buffer> buf = buffer::alloc(serialized_size());
+    buffer_serializer bs(buf);
+    serialize(bs);
+
+    return buf;
+}
+
+size_t splinterdb_operation::serialized_size() const {
+    size_t buffer_size = sizeof(type_);
+    if (type_ == BATCH) {
+        buffer_size += sizeof(uint32_t);
+        for (const auto& op : sub_operations_) {
+            buffer_size += op.serialized_size();
+        }
+
+        return buffer_size;
+    }
+
+    buffer_size += key_.serialized_size();
     if (value_.has_value()) {
         buffer_size += value_.value().serialized_size();
     }
 
-    ptr<buffer> buf = buffer::alloc(buffer_size);
-    buffer_serializer bs(buf);
+    return buffer_size;
+}
 
+void splinterdb_operation::serialize(buffer_serializer& bs) const {
     bs.put_u8(type_);
+    if (type_ == BATCH) {
+        bs.put_u32(static_cast<uint32_t>(sub_operations_.size()));
+        for (const auto& op : sub_operations_) {
+            op.serialize(bs);
+        }
+
+        return;
+    }
+
     key_.serialize(bs);
     if (value_.has_value()) {
         value_.value().serialize(bs);
     }
-
-    return buf;
 }
 
 splinterdb_operation::splinterdb_operation(owned_slice&& key,
@@ -31,18 +62,41 @@ splinterdb_operation::splinterdb_operation(owned_slice&& key,
                                            splinterdb_operation_type type)
     : key_(std::forward<owned_slice>(key)),
       value_(std::forward<std::optional<owned_slice>>(value)),
+      sub_operations_(),
       type_(type) {}
 
+splinterdb_operation::splinterdb_operation(
+    std::vector<splinterdb_operation>&& sub_operations)
+    : key_(),
+      value_(std::nullopt),
+      sub_operations_(
+          std::forward<std::vector<splinterdb_operation>>(sub_operations)),
+      type_(BATCH) {}
+
 splinterdb_operation splinterdb_operation::deserialize(buffer& payload_in) {
     buffer_serializer bs(payload_in);
+    return deserialize(bs);
+}
 
+splinterdb_operation splinterdb_operation::deserialize(buffer_serializer& bs) {
     auto opty = static_cast<splinterdb_operation_type>(bs.get_u8());
+    if (opty == splinterdb_operation::BATCH) {
+        uint32_t num_ops = bs.get_u32();
+
+        std::vector<splinterdb_operation> ops;
+        ops.reserve(num_ops);
+        for (uint32_t i = 0; i < num_ops; ++i) {
+            ops.push_back(deserialize(bs));
+        }
+
+        return make_batch(std::move(ops));
+    }
+
     owned_slice key_buf;
     owned_slice::deserialize(key_buf, bs);
 
     std::optional<owned_slice> value_buf;
-    if (opty == splinterdb_operation::PUT ||
-        opty == splinterdb_operation::UPDATE) {
+    if (has_value(opty)) {
         owned_slice value;
         owned_slice::deserialize(value, bs);
         value_buf = std::move(value);
@@ -68,4 +122,68 @@ splinterdb_operation splinterdb_operation::make_delete(owned_slice&& key) {
                                 DELETE};
 }
 
+splinterdb_operation splinterdb_operation::make_batch(
+    std::vector<splinterdb_operation>&& operations) {
+    for (const auto& op : operations) {
+        if (op.type() == BATCH) {
+            throw std::invalid_argument("Batch operations cannot be nested.");
+        }
+    }
+
+    return splinterdb_operation{
+        std::forward<std::vector<splinterdb_operation>>(operations)};
+}
+
+ptr<buffer> splinterdb_operation::serialize_batch(
+    const std::vector<const splinterdb_operation*>& operations) {
+    size_t buffer_size = sizeof(splinterdb_operation_type) + sizeof(uint32_t);
+    for (const auto* op : operations) {
+        if (op->type() == BATCH) {
+            throw std::invalid_argument("Batch operations cannot be nested.");
+        }
+
+        buffer_size += op->serialized_size();
+    }
+
+    ptr<buffer> buf = buffer::alloc(buffer_size);
+    buffer_serializer bs(buf);
+
+    bs.put_u8(BATCH);
+    bs.put_u32(static_cast<uint32_t>(operations.size()));
+    for (const auto* op : operations) {
+        op->serialize(bs);
+    }
+
+    return buf;
+}
+
+splinterdb_operation_view::splinterdb_operation_view(
+    slice key, slice value, splinterdb_operation_type type,
+    uint32_t batch_size)
+    : key_(key), value_(value), type_(type), batch_size_(batch_size) {}
+
+splinterdb_operation_view splinterdb_operation_view::deserialize(
+    buffer& payload_in) {
+    buffer_serializer bs(payload_in);
+    return deserialize(bs);
+}
+
+splinterdb_operation_view splinterdb_operation_view::deserialize(
+    buffer_serializer& bs) {
+    auto opty = static_cast<splinterdb_operation_type>(bs.get_u8());
+
+    slice key = slice_create(0, NULL);
+    slice value = slice_create(0, NULL);
+    if (opty == splinterdb_operation::BATCH) {
+        return splinterdb_operation_view{key, value, opty, bs.get_u32()};
+    }
+
+    key = owned_slice::deserialize_view(bs);
+    if (has_value(opty)) {
+        value = owned_slice::deserialize_view(bs);
+    }
+
+    return splinterdb_operation_view{key, value, opty, 0};
+}
+
 }  // namespace replicated_splinterdb
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef REPLICATED_SPLINTERDB_SPLINTERDB_SNAPSHOT_H
 #define REPLICATED_SPLINTERDB_SPLINTERDB_SNAPSHOT_H
 
+#include <map>
+#include <string>
+
 #include "libnuraft/nuraft.hxx"
 
 namespace replicated_splinterdb {
@@ -12,6 +15,19 @@ struct splinterdb_snapshot {
     nuraft::ptr<nuraft::snapshot> snapshot_;
 };
 
+/**
+ * Sender-side context passed through `read_logical_snp_obj` calls.
+ *
+ * Object 0 is a header; every object after that is a chunk of key-value
+ * pairs, read from the snapshot file at `path_`. For each chunk we remember
+ * where it starts in the file, so that NuRaft can re-request an object after
+ * a failed send without us keeping the file open across calls (and threads).
+ */
+struct splinterdb_snapshot_read_ctx {
+    std::string path_;
+    std::map<uint64_t, uint64_t> offsets_;
+};
+
 }  // namespace replicated_splinterdb
 
-#endif  // REPLICATED_SPLINTERDB_SPLINTERDB_SNAPSHOT_H
\ No newline at end of file
+#endif  // REPLICATED_SPLINTERDB_SPLINTERDB_SNAPSHOT_H
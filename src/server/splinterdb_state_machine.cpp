@@ -1,90 +1,514 @@
 #include "splinterdb_state_machine.h"
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <unordered_set>
 
-#include "common/timer.h"
+#include "common/crc32c.h"
+#include "key_space.h"
+#include "logger.h"
 #include "server/splinterdb_operation.h"
 
+#define s_warn _s_warn(std::dynamic_pointer_cast<SimpleLogger>(logger_))
+#define s_trace _s_trace(std::dynamic_pointer_cast<SimpleLogger>(logger_))
+
 namespace replicated_splinterdb {
 
 using nuraft::async_result;
 using nuraft::buffer;
 using nuraft::buffer_serializer;
 using nuraft::cluster_config;
+using nuraft::cs_new;
 using nuraft::ptr;
 using nuraft::snapshot;
 using nuraft::ulong;
 
+// Number of snapshots whose metadata we keep around.
+static constexpr size_t MAX_SNAPSHOTS = 3;
+
+// Number of keys collected per iterator pass when clearing the store.
+static constexpr size_t CLEAR_BATCH_SIZE = 1024;
+
+// Size of the per-chunk header: the number of key-value pairs, and the CRC32C
+// of the pairs.
+static constexpr size_t SNAPSHOT_CHUNK_HEADER_SIZE =
+    sizeof(uint32_t) + sizeof(uint32_t);
+
+// Maximum number of result buffers kept around for reuse.
+static constexpr size_t RESULT_POOL_SIZE = 64;
+
+// Holds the index of the last applied log entry.
+static const char APPLIED_IDX_KEY[] = {RESERVED_KEY_PREFIX[0],
+                                       RESERVED_KEY_PREFIX[1], META_PARTITION,
+                                       'a', 'p', 'p', 'l', 'i', 'e', 'd'};
+static const slice APPLIED_IDX_SLICE =
+    slice_create(sizeof(APPLIED_IDX_KEY), APPLIED_IDX_KEY);
+
+// Holds the metadata of the latest snapshot, so that a restarted leader whose
+// log has been compacted can still send it.
+static const char SNAPSHOT_META_KEY[] = {
+    RESERVED_KEY_PREFIX[0], RESERVED_KEY_PREFIX[1], META_PARTITION,
+    's', 'n', 'a', 'p', 's', 'h', 'o', 't'};
+static const slice SNAPSHOT_META_SLICE =
+    slice_create(sizeof(SNAPSHOT_META_KEY), SNAPSHOT_META_KEY);
+
+// Appended to the SplinterDB file name, followed by the snapshot index, to
+// name a snapshot file.
+static const char SNAPSHOT_FILE_SUFFIX[] = ".snapshot-";
+
+static size_t snapshot_pair_size(const slice& key, const slice& value) {
+    return 2 * sizeof(uint64_t) + slice_length(key) + slice_length(value);
+}
+
+static void put_slice(buffer_serializer& bs, const slice& s) {
+    bs.put_u64(slice_length(s));
+    bs.put_raw(slice_data(s), slice_length(s));
+}
+
+/**
+ * Look up one of the server's own keys.
+ *
+ * @return The value, or null if the key is not there.
+ */
+static ptr<buffer> lookup_meta(splinterdb* spl, slice key) {
+    ptr<buffer> ret = nullptr;
+    splinterdb_lookup_result result;
+    splinterdb_lookup_result_init(spl, &result, 0, NULL);
+    if (splinterdb_lookup(spl, key, &result) == 0) {
+        slice value;
+        if (splinterdb_lookup_result_value(&result, &value) == 0) {
+            ret = buffer::alloc(slice_length(value));
+            ret->put_raw(static_cast<const nuraft::byte*>(slice_data(value)),
+                         slice_length(value));
+            ret->pos(0);
+        }
+    }
+    splinterdb_lookup_result_deinit(&result);
+    return ret;
+}
+
 splinterdb_state_machine::splinterdb_state_machine(
-    const splinterdb_config& cfg_ref, bool disable_snapshots)
-    : spl_handle_(nullptr),
+    const splinterdb_config& cfg_ref, ptr<nuraft::logger> logger,
+    bool disable_snapshots, size_t snapshot_chunk_size, bool reopen)
+    : spl_cfg_(cfg_ref),
+      data_cfg_(),
+      spl_handle_(nullptr),
+      logger_(logger),
+      raft_(nullptr),
       last_committed_idx_(0),
-      commit_thread_initialized_(false),
+      apply_waiters_(0),
+      apply_lock_(),
+      apply_cv_(),
       snapshots_(),
       snapshots_lock_(),
-      disable_snapshots_(disable_snapshots) {
-    if (splinterdb_create(&cfg_ref, &spl_handle_)) {
+      disable_snapshots_(disable_snapshots),
+      snapshot_chunk_size_(snapshot_chunk_size),
+      result_pool_(),
+      result_pool_next_(0),
+      batch_ret_codes_(),
+      batch_timer_(),
+      batch_entries_(0),
+      batch_bytes_(0),
+      stats_(),
+      stats_lock_(),
+      key_changes_(),
+      receiving_() {
+    result_pool_.reserve(RESULT_POOL_SIZE);
+
+    partitioned_data_config_init(*cfg_ref.data_cfg, &data_cfg_);
+    spl_cfg_.data_cfg = &data_cfg_.cfg_;
+
+    if (reopen && std::filesystem::exists(spl_cfg_.filename)) {
+        if (splinterdb_open(&spl_cfg_, &spl_handle_)) {
+            throw std::runtime_error("Failed to open SplinterDB instance.");
+        }
+
+        ptr<buffer> applied = lookup_meta(spl_handle_, APPLIED_IDX_SLICE);
+        if (applied && applied->size() == sizeof(uint64_t)) {
+            uint64_t applied_idx;
+            memcpy(&applied_idx, applied->data_begin(), sizeof(applied_idx));
+            last_committed_idx_ = applied_idx;
+        }
+
+        uint64_t snapshot_idx = 0;
+        ptr<buffer> snp_buf = lookup_meta(spl_handle_, SNAPSHOT_META_SLICE);
+        if (snp_buf) {
+            ptr<snapshot> snp = snapshot::deserialize(*snp_buf);
+            snapshot_idx = snp->get_last_log_idx();
+            snapshots_[snapshot_idx] = cs_new<splinterdb_snapshot>(snp);
+        }
+        remove_snapshot_files(snapshot_idx);
+
+        // What changed before the restart is not known.
+        key_changes_.reset(last_committed_idx_);
+        key_changes_.applied(last_committed_idx_);
+    } else if (splinterdb_create(&spl_cfg_, &spl_handle_)) {
         throw std::runtime_error("Failed to create SplinterDB instance.");
+    } else {
+        remove_snapshot_files(0);
+    }
+}
+
+/**
+ * @return `true` if the serialized operation `buf` is or holds an UPDATE.
+ */
+static bool holds_update(buffer& buf) {
+    buffer_serializer bs(buf);
+    auto op = splinterdb_operation_view::deserialize(bs);
+    if (op.type() != splinterdb_operation::BATCH) {
+        return op.type() == splinterdb_operation::UPDATE;
+    }
+
+    for (uint32_t i = 0; i < op.batch_size(); ++i) {
+        if (splinterdb_operation_view::deserialize(bs).type() ==
+            splinterdb_operation::UPDATE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void splinterdb_state_machine::recover(nuraft::log_store& log) {
+    bool replays_update = false;
+    for (ulong i = last_committed_idx_ + 1; i < log.next_slot(); ++i) {
+        ptr<nuraft::log_entry> entry = log.entry_at(i);
+        if (entry && entry->get_val_type() == nuraft::log_val_type::app_log &&
+            holds_update(entry->get_buf())) {
+            replays_update = true;
+            break;
+        }
+    }
+    if (!replays_update) {
+        return;
+    }
+
+    uint64_t snapshot_idx = 0;
+    {
+        std::lock_guard<std::mutex> ll(snapshots_lock_);
+        if (!snapshots_.empty()) {
+            snapshot_idx = snapshots_.rbegin()->first;
+        }
+    }
+
+    // The log has to go back far enough to apply everything again.
+    if (log.start_index() > snapshot_idx + 1) {
+        s_warn << "log starts at " << log.start_index()
+               << ", after the latest snapshot at " << snapshot_idx
+               << "; UPDATEs from " << last_committed_idx_ + 1
+               << " on may be merged twice";
+        return;
+    }
+
+    s_warn << "UPDATEs from " << last_committed_idx_ + 1
+           << " on may have been applied already, going back to the "
+           << "snapshot at " << snapshot_idx;
+
+    register_thread_if_needed();
+    std::string path = snapshot_path(snapshot_idx);
+    if (snapshot_idx > 0 && !std::filesystem::exists(path)) {
+        throw std::runtime_error("Missing snapshot file " + path);
+    }
+
+    clear_all_keys();
+    uint64_t offset = 0;
+    bool is_last = snapshot_idx == 0;
+    while (!is_last) {
+        ptr<buffer> chunk = read_snapshot_chunk(path, offset, offset, is_last);
+        if (!chunk || !load_snapshot_chunk(*chunk)) {
+            throw std::runtime_error("Corrupted snapshot file " + path);
+        }
     }
+
+    set_last_committed_idx(snapshot_idx);
+    persist_applied_idx(snapshot_idx);
+    key_changes_.reset(snapshot_idx);
 }
 
 splinterdb_state_machine::~splinterdb_state_machine() {
+    persist_applied_idx(last_committed_idx_);
     splinterdb_close(&spl_handle_);
 }
 
-ptr<buffer> splinterdb_state_machine::commit(const ulong log_idx, buffer& buf) {
-    bool expected = false;
-    if (commit_thread_initialized_.compare_exchange_strong(expected, true)) {
-        std::cout << "Registering commit thread." << std::endl;
+void splinterdb_state_machine::persist_applied_idx(uint64_t log_idx) {
+    // SplinterDB has no multi-key transactions. The index is written after
+    // the data it covers, so it never claims more than has been applied, and
+    // the entries after it are applied again after a crash. That is harmless
+    // for PUT and DELETE; before an UPDATE is merged a second time, `recover`
+    // goes back to the latest snapshot instead.
+    splinterdb_insert(spl_handle_, APPLIED_IDX_SLICE,
+                      slice_create(sizeof(log_idx), &log_idx));
+}
+
+void splinterdb_state_machine::register_thread_if_needed() {
+    // A thread may serve the state machines of several replicas, each with a
+    // SplinterDB instance of its own.
+    thread_local std::unordered_set<const splinterdb*> registered;
+    if (registered.insert(spl_handle_).second) {
         splinterdb_register_thread(spl_handle_);
     }
+}
+
+ptr<buffer> splinterdb_state_machine::commit(const ulong log_idx, buffer& buf) {
+    register_thread_if_needed();
+
+    if (batch_entries_ == 0) {
+        batch_timer_.reset();
+    }
 
-    Timer timer;
+    batch_ret_codes_.clear();
+    int32_t ret_code = apply_operation(buf, log_idx);
+    set_last_committed_idx(log_idx);
 
-    splinterdb_operation operation = splinterdb_operation::deserialize(buf);
-    slice key_slice, value_slice;
-    int32_t ret_code;
+    batch_entries_++;
+    batch_bytes_ += buf.size();
+    end_batch_if_caught_up(log_idx);
 
-    operation.key().fill_slice(key_slice);
+    if (batch_ret_codes_.empty()) {
+        return make_result(ret_code, log_idx);
+    }
+
+    // Result of a BATCH: the overall return code and log number, followed by
+    // the return code of every sub-operation.
+    ptr<buffer> ret = buffer::alloc(sizeof(int32_t) + sizeof(uint64_t) +
+                                    sizeof(uint32_t) +
+                                    batch_ret_codes_.size() * sizeof(int32_t));
+    buffer_serializer bs(ret);
+    bs.put_i32(ret_code);
+    bs.put_u64(log_idx);
+    bs.put_u32(static_cast<uint32_t>(batch_ret_codes_.size()));
+    for (int32_t rc : batch_ret_codes_) {
+        bs.put_i32(rc);
+    }
+
+    return ret;
+}
+
+int32_t splinterdb_state_machine::apply_operation(buffer& buf,
+                                                  ulong log_idx) {
+    // Views point straight into `buf`, which NuRaft keeps alive for the
+    // duration of the commit call.
+    buffer_serializer bs(buf);
+    auto op = splinterdb_operation_view::deserialize(bs);
+    if (op.type() != splinterdb_operation::BATCH) {
+        return apply_operation(op, log_idx);
+    }
 
-    switch (operation.type()) {
+    // Decode the whole batch before applying any of it, so that a malformed
+    // entry is rejected as a whole rather than applied halfway.
+    size_t sub_ops_pos = bs.pos();
+    for (uint32_t i = 0; i < op.batch_size(); ++i) {
+        auto sub_op = splinterdb_operation_view::deserialize(bs);
+        if (sub_op.type() > splinterdb_operation::DELETE) {
+            throw std::runtime_error("Invalid operation type in batch.");
+        }
+    }
+    bs.pos(sub_ops_pos);
+
+    // Every sub-operation is applied; the first failure is reported.
+    int32_t ret_code = 0;
+    for (uint32_t i = 0; i < op.batch_size(); ++i) {
+        int32_t rc = apply_operation(
+            splinterdb_operation_view::deserialize(bs), log_idx);
+        batch_ret_codes_.push_back(rc);
+        if (ret_code == 0) {
+            ret_code = rc;
+        }
+    }
+
+    return ret_code;
+}
+
+int32_t splinterdb_state_machine::apply_operation(
+    const splinterdb_operation_view& op, ulong log_idx) {
+    key_changes_.record(log_idx, op.key());
+
+    stored_key key(op.key());
+    switch (op.type()) {
         case splinterdb_operation::PUT:
-            operation.value().fill_slice(value_slice);
-            ret_code = splinterdb_insert(spl_handle_, key_slice, value_slice);
-            break;
+            return splinterdb_insert(spl_handle_, key.get(), op.value());
         case splinterdb_operation::UPDATE:
-            operation.value().fill_slice(value_slice);
-            ret_code = splinterdb_update(spl_handle_, key_slice, value_slice);
-            break;
+            return splinterdb_update(spl_handle_, key.get(), op.value());
         case splinterdb_operation::DELETE:
-            ret_code = splinterdb_delete(spl_handle_, key_slice);
-            break;
+            return splinterdb_delete(spl_handle_, key.get());
         default:
             throw std::runtime_error("Unknown operation type.");
     }
+}
 
-    last_committed_idx_ = log_idx;
+void splinterdb_state_machine::end_batch_if_caught_up(ulong log_idx) {
+    // NuRaft applies committed entries one at a time, back-to-back, until
+    // it reaches the commit target. Without a Raft server to ask (e.g.
+    // during start-up) every entry is treated as its own batch.
+    nuraft::raft_server* raft = raft_;
+    if (batch_entries_ == 0 ||
+        (raft != nullptr && log_idx < raft->get_target_committed_log_idx())) {
+        return;
+    }
+
+    uint64_t elapsed_us = batch_timer_.getTimeUs();
+    {
+        std::lock_guard<std::mutex> ll(stats_lock_);
+        stats_.batches_++;
+        stats_.entries_ += batch_entries_;
+        stats_.bytes_ += batch_bytes_;
+        stats_.last_batch_entries_ = batch_entries_;
+        stats_.last_batch_bytes_ = batch_bytes_;
+        stats_.last_batch_us_ = elapsed_us;
+    }
+
+    // Once per batch keeps the cost of this off the per-entry path.
+    persist_applied_idx(log_idx);
+
+    s_trace << "applied batch ending at " << log_idx << ": " << batch_entries_
+            << " entries, " << batch_bytes_ << " bytes in "
+            << usToString(elapsed_us) << " ("
+            << (batch_entries_ * 1000000 / std::max<uint64_t>(elapsed_us, 1))
+            << " entries/s)";
+
+    batch_entries_ = 0;
+    batch_bytes_ = 0;
+}
+
+ptr<buffer> splinterdb_state_machine::make_result(int32_t ret_code,
+                                                  ulong log_idx) {
+    ptr<buffer> ret = nullptr;
+    for (size_t i = 0; i < result_pool_.size(); ++i) {
+        size_t idx = (result_pool_next_ + i) % result_pool_.size();
+        if (result_pool_[idx].use_count() == 1) {
+            // Pair with the release of the last outside reference.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            ret = result_pool_[idx];
+            result_pool_next_ = idx + 1;
+            break;
+        }
+    }
+
+    if (ret == nullptr) {
+        ret = buffer::alloc(sizeof(ret_code) + sizeof(uint64_t));
+        if (result_pool_.size() < RESULT_POOL_SIZE) {
+            result_pool_.push_back(ret);
+        }
+    }
 
-    ptr<buffer> ret = buffer::alloc(sizeof(ret_code));
     buffer_serializer bs(ret);
     bs.put_i32(ret_code);
+    bs.put_u64(log_idx);
+    ret->pos(0);
     return ret;
 }
 
+void splinterdb_state_machine::set_last_committed_idx(uint64_t log_idx) {
+    last_committed_idx_ = log_idx;
+    key_changes_.applied(log_idx);
+
+    if (apply_waiters_ > 0) {
+        // Taking the lock makes sure a waiter is either already blocked or
+        // will see the new index before it blocks.
+        std::lock_guard<std::mutex> ll(apply_lock_);
+        apply_cv_.notify_all();
+    }
+}
+
+bool splinterdb_state_machine::wait_for_apply(uint64_t log_idx,
+                                              uint64_t timeout_ms) {
+    if (last_committed_idx_ >= log_idx) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> ll(apply_lock_);
+    apply_waiters_++;
+    bool applied = apply_cv_.wait_for(
+        ll, std::chrono::milliseconds(timeout_ms),
+        [this, log_idx] { return last_committed_idx_ >= log_idx; });
+    apply_waiters_--;
+
+    return applied;
+}
+
+apply_stats splinterdb_state_machine::get_apply_stats() {
+    std::lock_guard<std::mutex> ll(stats_lock_);
+    return stats_;
+}
+
 void splinterdb_state_machine::commit_config(const ulong log_idx,
                                              ptr<cluster_config>& new_conf) {
-    last_committed_idx_ = log_idx;
+    set_last_committed_idx(log_idx);
+    end_batch_if_caught_up(log_idx);
 }
 
 void splinterdb_state_machine::save_logical_snp_obj(snapshot& s, ulong& obj_id,
                                                     buffer& data,
                                                     bool is_first_obj,
                                                     bool is_last_obj) {
-    throw std::runtime_error("Not implemented.");
+    register_thread_if_needed();
+
+    if (obj_id == 0) {
+        // Header object: a new snapshot is being installed, so anything we
+        // hold locally is about to be replaced. The chunks are kept in a
+        // snapshot file as well, as if the snapshot had been taken here.
+        receiving_ = std::make_unique<snapshot_file_writer>(
+            snapshot_path(s.get_last_log_idx()));
+        key_changes_.reset(last_committed_idx_ + 1);
+        clear_all_keys();
+    } else {
+        if (!load_snapshot_chunk(data)) {
+            // Leave `obj_id` as it is, so that the leader sends the object
+            // again.
+            s_warn << "snapshot object " << obj_id
+                   << " failed its checksum, requesting it again";
+            return;
+        }
+
+        if (receiving_) {
+            receiving_->append(data.data_begin(), data.size());
+        }
+    }
+
+    // Request the next object.
+    obj_id++;
+}
+
+bool splinterdb_state_machine::load_snapshot_chunk(buffer& chunk) {
+    buffer_serializer bs(chunk);
+    uint32_t num_pairs = 0;
+    uint32_t crc = 0;
+    if (chunk.size() >= SNAPSHOT_CHUNK_HEADER_SIZE) {
+        num_pairs = bs.get_u32();
+        crc = bs.get_u32();
+    }
+
+    if (chunk.size() < SNAPSHOT_CHUNK_HEADER_SIZE ||
+        crc32c(chunk.data_begin() + SNAPSHOT_CHUNK_HEADER_SIZE,
+               chunk.size() - SNAPSHOT_CHUNK_HEADER_SIZE) != crc) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < num_pairs; ++i) {
+        slice key = owned_slice::deserialize_view(bs);
+        slice value = owned_slice::deserialize_view(bs);
+
+        if (splinterdb_insert(spl_handle_, key, value)) {
+            throw std::runtime_error(
+                "Failed to insert snapshot data into SplinterDB.");
+        }
+    }
+    return true;
 }
 
 bool splinterdb_state_machine::apply_snapshot(snapshot& s) {
-    throw std::runtime_error("Not implemented.");
+    // All objects have already been written by `save_logical_snp_obj`.
+    if (receiving_) {
+        receiving_->commit();
+        receiving_.reset();
+    }
+
+    key_changes_.reset(s.get_last_log_idx());
+    set_last_committed_idx(s.get_last_log_idx());
+    persist_applied_idx(s.get_last_log_idx());
+    save_snapshot_meta(s);
+    return true;
 }
 
 int splinterdb_state_machine::read_logical_snp_obj(nuraft::snapshot& s,
@@ -92,11 +516,53 @@ int splinterdb_state_machine::read_logical_snp_obj(nuraft::snapshot& s,
                                                    ulong obj_id,
                                                    ptr<buffer>& data_out,
                                                    bool& is_last_obj) {
-    throw std::runtime_error("Not implemented.");
+    if (obj_id == 0) {
+        // Header object: carries the snapshot index so that it is never
+        // empty, and starts a fresh read context.
+        if (user_snp_ctx == nullptr) {
+            auto* ctx = new splinterdb_snapshot_read_ctx();
+            ctx->path_ = snapshot_path(s.get_last_log_idx());
+            ctx->offsets_[1] = 0;
+            user_snp_ctx = ctx;
+        }
+
+        data_out = buffer::alloc(sizeof(ulong));
+        buffer_serializer bs(data_out);
+        bs.put_u64(s.get_last_log_idx());
+        is_last_obj = false;
+        return 0;
+    }
+
+    auto* ctx = static_cast<splinterdb_snapshot_read_ctx*>(user_snp_ctx);
+    if (ctx == nullptr) {
+        return -1;
+    }
+
+    auto offset = ctx->offsets_.find(obj_id);
+    if (offset == ctx->offsets_.end()) {
+        return -1;
+    }
+
+    // The chunks come from the snapshot file, which holds the data exactly
+    // as it was at `s.get_last_log_idx()`: the receiver replays the log from
+    // there, and an UPDATE must not find itself merged already.
+    uint64_t next_offset = 0;
+    data_out =
+        read_snapshot_chunk(ctx->path_, offset->second, next_offset,
+                            is_last_obj);
+    if (!data_out) {
+        s_warn << "cannot read snapshot object " << obj_id << " from "
+               << ctx->path_;
+        return -1;
+    }
+
+    ctx->offsets_[obj_id + 1] = next_offset;
+    return 0;
 }
 
 void splinterdb_state_machine::free_user_snp_ctx(void*& user_snp_ctx) {
-    throw std::runtime_error("Not implemented.");
+    delete static_cast<splinterdb_snapshot_read_ctx*>(user_snp_ctx);
+    user_snp_ctx = nullptr;
 }
 
 nuraft::ptr<nuraft::snapshot> splinterdb_state_machine::last_snapshot() {
@@ -115,7 +581,173 @@ ulong splinterdb_state_machine::last_commit_index() {
 
 void splinterdb_state_machine::create_snapshot(
     snapshot& s, async_result<bool>::handler_type& when_done) {
-    throw std::runtime_error("Not implemented.");
+    // SplinterDB has no point-in-time view to stream from later, so the data
+    // is copied right away, before any later entry is applied. The applied
+    // index goes first, so that it never trails the snapshot after a
+    // restart.
+    register_thread_if_needed();
+
+    ptr<std::exception> except(nullptr);
+    bool ret = true;
+    try {
+        if (last_committed_idx_ != s.get_last_log_idx()) {
+            throw std::runtime_error(
+                "Snapshot at " + std::to_string(s.get_last_log_idx()) +
+                " taken with " + std::to_string(last_committed_idx_) +
+                " applied");
+        }
+
+        write_snapshot_file(s.get_last_log_idx());
+        persist_applied_idx(last_committed_idx_);
+        save_snapshot_meta(s);
+    } catch (const std::exception& e) {
+        s_warn << "failed to create snapshot: " << e.what();
+        except = cs_new<std::runtime_error>(e.what());
+        ret = false;
+    }
+
+    when_done(ret, except);
+}
+
+void splinterdb_state_machine::save_snapshot_meta(snapshot& s) {
+    // Clone the snapshot, since the given instance is owned by the caller.
+    ptr<buffer> snp_buf = s.serialize();
+    ptr<snapshot> snp = snapshot::deserialize(*snp_buf);
+
+    splinterdb_insert(spl_handle_, SNAPSHOT_META_SLICE,
+                      slice_create(snp_buf->size(), snp_buf->data_begin()));
+
+    std::lock_guard<std::mutex> ll(snapshots_lock_);
+    snapshots_[s.get_last_log_idx()] = cs_new<splinterdb_snapshot>(snp);
+
+    while (snapshots_.size() > MAX_SNAPSHOTS) {
+        std::error_code ec;
+        std::filesystem::remove(snapshot_path(snapshots_.begin()->first), ec);
+        snapshots_.erase(snapshots_.begin());
+    }
+}
+
+std::string splinterdb_state_machine::snapshot_path(uint64_t log_idx) const {
+    return std::string(spl_cfg_.filename) + SNAPSHOT_FILE_SUFFIX +
+           std::to_string(log_idx);
+}
+
+void splinterdb_state_machine::write_snapshot_file(uint64_t log_idx) {
+    snapshot_file_writer file(snapshot_path(log_idx));
+
+    splinterdb_iterator* it = nullptr;
+    if (splinterdb_iterator_init(spl_handle_, &it, client_keys_start())) {
+        throw std::runtime_error("Failed to initialize iterator.");
+    }
+
+    try {
+        // Even an empty store gets a chunk, which is sent as the last
+        // object.
+        ptr<buffer> chunk = nullptr;
+        bool is_last = false;
+        while (!is_last) {
+            // A single pair larger than the chunk size goes on its own.
+            size_t capacity = snapshot_chunk_size_;
+            if (splinterdb_iterator_valid(it)) {
+                slice key, value;
+                splinterdb_iterator_get_current(it, &key, &value);
+                capacity = std::max(capacity, snapshot_pair_size(key, value));
+            }
+            size_t chunk_capacity = SNAPSHOT_CHUNK_HEADER_SIZE + capacity;
+            if (!chunk || chunk->size() < chunk_capacity) {
+                chunk = buffer::alloc(chunk_capacity);
+            }
+
+            buffer_serializer bs(chunk);
+            bs.put_u32(0);
+            bs.put_u32(0);
+
+            uint32_t num_pairs = 0;
+            for (; splinterdb_iterator_valid(it);
+                 splinterdb_iterator_next(it)) {
+                slice key, value;
+                splinterdb_iterator_get_current(it, &key, &value);
+                if (is_reserved_key(key)) {
+                    continue;
+                }
+
+                if (bs.pos() + snapshot_pair_size(key, value) >
+                    chunk_capacity) {
+                    break;
+                }
+
+                put_slice(bs, key);
+                put_slice(bs, value);
+                num_pairs++;
+            }
+
+            if (splinterdb_iterator_status(it) != 0) {
+                throw std::runtime_error("Failed to iterate over SplinterDB.");
+            }
+            is_last = !splinterdb_iterator_valid(it);
+
+            size_t chunk_size = bs.pos();
+            bs.pos(0);
+            bs.put_u32(num_pairs);
+            bs.put_u32(crc32c(chunk->data_begin() + SNAPSHOT_CHUNK_HEADER_SIZE,
+                              chunk_size - SNAPSHOT_CHUNK_HEADER_SIZE));
+            file.append(chunk->data_begin(), chunk_size);
+        }
+    } catch (...) {
+        splinterdb_iterator_deinit(it);
+        throw;
+    }
+
+    splinterdb_iterator_deinit(it);
+    file.commit();
+}
+
+void splinterdb_state_machine::remove_snapshot_files(uint64_t keep_idx) {
+    std::filesystem::path base(spl_cfg_.filename);
+    std::filesystem::path dir = base.parent_path();
+    std::string prefix = base.filename().string() + SNAPSHOT_FILE_SUFFIX;
+    std::string keep = prefix + std::to_string(keep_idx);
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(
+             dir.empty() ? std::filesystem::path(".") : dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) == 0 && name != keep) {
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+}
+
+void splinterdb_state_machine::clear_all_keys() {
+    std::vector<std::vector<uint8_t>> keys;
+    keys.reserve(CLEAR_BATCH_SIZE);
+
+    do {
+        keys.clear();
+
+        splinterdb_iterator* it = nullptr;
+        if (splinterdb_iterator_init(spl_handle_, &it, client_keys_start())) {
+            throw std::runtime_error("Failed to initialize iterator.");
+        }
+
+        for (; splinterdb_iterator_valid(it) && keys.size() < CLEAR_BATCH_SIZE;
+             splinterdb_iterator_next(it)) {
+            slice key, value;
+            splinterdb_iterator_get_current(it, &key, &value);
+            if (is_reserved_key(key)) {
+                continue;
+            }
+
+            auto* bytes = static_cast<const uint8_t*>(slice_data(key));
+            keys.emplace_back(bytes, bytes + slice_length(key));
+        }
+        splinterdb_iterator_deinit(it);
+
+        for (const auto& key : keys) {
+            splinterdb_delete(spl_handle_,
+                              slice_create(key.size(), key.data()));
+        }
+    } while (!keys.empty());
 }
 
-}  // namespace replicated_splinterdb
\ No newline at end of file
+}  // namespace replicated_splinterdb
@@ -1,14 +1,37 @@
 #ifndef REPLICATED_SPLINTERDB_SPLINTERDB_STATE_MACHINE_H
 #define REPLICATED_SPLINTERDB_SPLINTERDB_STATE_MACHINE_H
 
+#include <condition_variable>
 #include <map>
+#include <memory>
+#include <string>
 
+#include "common/timer.h"
+#include "key_change_log.h"
+#include "key_space.h"
 #include "libnuraft/nuraft.hxx"
+#include "server/splinterdb_operation.h"
 #include "server/splinterdb_wrapper.h"
+#include "snapshot_file.h"
 #include "splinterdb_snapshot.h"
 
 namespace replicated_splinterdb {
 
+/**
+ * Counters describing how committed entries have been applied. A batch is a
+ * run of consecutive entries applied back-to-back until the state machine
+ * caught up with the commit index.
+ */
+struct apply_stats {
+    uint64_t batches_ = 0;
+    uint64_t entries_ = 0;
+    uint64_t bytes_ = 0;
+
+    uint64_t last_batch_entries_ = 0;
+    uint64_t last_batch_bytes_ = 0;
+    uint64_t last_batch_us_ = 0;
+};
+
 class splinterdb_state_machine : public nuraft::state_machine {
   private:
     using Base = nuraft::state_machine;
@@ -19,11 +42,35 @@ class splinterdb_state_machine : public nuraft::state_machine {
         delete;
 
   public:
-    splinterdb_state_machine(const splinterdb_config& config,
-                             bool disable_snapshots = false);
+    // Default upper bound on the size of a single logical snapshot object.
+    static constexpr size_t DEFAULT_SNAPSHOT_CHUNK_SIZE = 1024 * 1024;
+
+    /**
+     * With `reopen`, an existing database file is opened rather than
+     * replaced, and applying resumes after the last entry applied to it.
+     * The instance is always set up so that it can hold the Raft log as well
+     * (see `key_space.h`).
+     */
+    splinterdb_state_machine(
+        const splinterdb_config& config,
+        nuraft::ptr<nuraft::logger> logger = nullptr,
+        bool disable_snapshots = false,
+        size_t snapshot_chunk_size = DEFAULT_SNAPSHOT_CHUNK_SIZE,
+        bool reopen = false);
 
     ~splinterdb_state_machine();
 
+    /**
+     * Get a reopened instance ready to apply the entries of `log` after the
+     * last one applied to it. Entries that were being applied when the
+     * server went down are applied again; should any of them hold an
+     * UPDATE, which must not be merged twice, the data goes back to the
+     * latest snapshot and applying resumes from there.
+     *
+     * @throws std::runtime_error If the snapshot file cannot be read.
+     */
+    void recover(nuraft::log_store& log);
+
     /**
      * Commit the given Raft log.
      *
@@ -151,7 +198,9 @@ class splinterdb_state_machine : public nuraft::state_machine {
     nuraft::ulong last_commit_index() override;
 
     /**
-     * Create a snapshot corresponding to the given info.
+     * Create a snapshot corresponding to the given info. The client data is
+     * copied to a snapshot file right away, while NuRaft holds off applying
+     * further entries, so the snapshot is exactly the state at its index.
      *
      * @param s Snapshot info to create.
      * @param when_done Callback function that will be called after
@@ -177,14 +226,60 @@ class splinterdb_state_machine : public nuraft::state_machine {
 
     inline splinterdb* get_splinterdb_handle() const { return spl_handle_; }
 
+    /**
+     * Set the Raft server driving this state machine. It is used to find
+     * out where the current run of committed entries ends, so that apply
+     * statistics can be reported per batch.
+     */
+    void set_raft_server(nuraft::raft_server* raft) { raft_ = raft; }
+
+    /**
+     * Get a copy of the apply statistics gathered so far.
+     */
+    apply_stats get_apply_stats();
+
+    /**
+     * Wait until the Raft log `log_idx` has been applied, for at most
+     * `timeout_ms` milliseconds.
+     *
+     * @return `true` if the log has been applied.
+     */
+    bool wait_for_apply(uint64_t log_idx, uint64_t timeout_ms);
+
+    /**
+     * The keys changed by recently applied entries, for clients that cache
+     * values.
+     */
+    const key_change_log& get_key_changes() const { return key_changes_; }
+
   private:
+    // Copy of the configuration handed in, using `data_cfg_`.
+    splinterdb_config spl_cfg_;
+
+    // The client's data config, with reserved keys (see `key_space.h`)
+    // sorted before all client keys, and client keys unescaped for the
+    // client's callbacks.
+    partitioned_data_config data_cfg_;
+
     splinterdb* spl_handle_;
 
+    nuraft::ptr<nuraft::logger> logger_;
+
+    /**
+     * Backward pointer to Raft server.
+     */
+    std::atomic<nuraft::raft_server*> raft_;
+
     // Last committed Raft log number.
     std::atomic<uint64_t> last_committed_idx_;
 
-    // Track whether the commit thread has been registered by splinterdb
-    std::atomic<bool> commit_thread_initialized_;
+    // Number of threads blocked in `wait_for_apply`, so that commits only
+    // take `apply_lock_` when somebody is waiting.
+    std::atomic<size_t> apply_waiters_;
+
+    // Mutex and condition for `wait_for_apply`.
+    std::mutex apply_lock_;
+    std::condition_variable apply_cv_;
 
     // Keeps the last 3 snapshots, by their Raft log numbers.
     std::map<uint64_t, nuraft::ptr<splinterdb_snapshot>> snapshots_;
@@ -193,6 +288,120 @@ class splinterdb_state_machine : public nuraft::state_machine {
     std::mutex snapshots_lock_;
 
     bool disable_snapshots_;
+
+    // Soft upper bound on the serialized size of one snapshot object. A
+    // single key-value pair larger than this is still sent on its own.
+    size_t snapshot_chunk_size_;
+
+    // Result buffers handed back to NuRaft. A buffer is reused once nobody
+    // but the pool holds a reference to it anymore.
+    std::vector<nuraft::ptr<nuraft::buffer>> result_pool_;
+    size_t result_pool_next_;
+
+    // Return codes of the sub-operations of the BATCH being applied, reused
+    // across commits.
+    std::vector<int32_t> batch_ret_codes_;
+
+    // Progress of the batch currently being applied.
+    Timer batch_timer_;
+    uint64_t batch_entries_;
+    uint64_t batch_bytes_;
+
+    apply_stats stats_;
+
+    // Mutex for `stats_`.
+    std::mutex stats_lock_;
+
+    key_change_log key_changes_;
+
+    // The snapshot file being received from the leader, if any.
+    std::unique_ptr<snapshot_file_writer> receiving_;
+
+    /**
+     * Advance `last_committed_idx_` and wake up anybody waiting for it.
+     */
+    void set_last_committed_idx(uint64_t log_idx);
+
+    /**
+     * Record in SplinterDB, next to the data, that everything up to `log_idx`
+     * has been applied.
+     */
+    void persist_applied_idx(uint64_t log_idx);
+
+    /**
+     * Apply a serialized operation to SplinterDB. All sub-operations of a
+     * BATCH are applied as part of the same log entry.
+     *
+     * @return SplinterDB return code of the operation, or of the first
+     *         failed sub-operation of a batch. The return codes of all
+     *         sub-operations are recorded in `batch_ret_codes_`.
+     */
+    int32_t apply_operation(nuraft::buffer& data, nuraft::ulong log_idx);
+
+    /**
+     * Apply a single PUT, UPDATE or DELETE operation to SplinterDB, and
+     * record its key as changed by the entry at `log_idx`.
+     */
+    int32_t apply_operation(const splinterdb_operation_view& op,
+                            nuraft::ulong log_idx);
+
+    /**
+     * Close the current batch if `log_idx` is the last committed entry.
+     */
+    void end_batch_if_caught_up(nuraft::ulong log_idx);
+
+    /**
+     * Get a result buffer holding `ret_code` followed by the Raft log number
+     * the operation was applied at, from the pool if possible.
+     */
+    nuraft::ptr<nuraft::buffer> make_result(int32_t ret_code,
+                                            nuraft::ulong log_idx);
+
+    /**
+     * Register the calling thread with SplinterDB, once per thread. Commits
+     * run on the commit thread, but snapshot objects are saved on Asio
+     * worker threads.
+     */
+    void register_thread_if_needed();
+
+    /**
+     * Record the metadata of a snapshot, keeping only the most recent ones in
+     * memory and the latest one in SplinterDB. The files of the snapshots
+     * dropped go as well.
+     */
+    void save_snapshot_meta(nuraft::snapshot& s);
+
+    /**
+     * The snapshot file of the snapshot at `log_idx`, next to the SplinterDB
+     * file.
+     */
+    std::string snapshot_path(uint64_t log_idx) const;
+
+    /**
+     * Copy every client key-value pair to the snapshot file of the snapshot
+     * at `log_idx`.
+     */
+    void write_snapshot_file(uint64_t log_idx);
+
+    /**
+     * Insert the key-value pairs of a snapshot chunk.
+     *
+     * @return `false` if the chunk does not match its checksum. Nothing is
+     *         inserted then.
+     */
+    bool load_snapshot_chunk(nuraft::buffer& chunk);
+
+    /**
+     * Delete the snapshot files left behind by earlier runs, all but the one
+     * of the snapshot at `keep_idx`.
+     */
+    void remove_snapshot_files(uint64_t keep_idx);
+
+    /**
+     * Delete every key in the store. Used by a snapshot receiver before
+     * loading a snapshot so that keys deleted on the leader do not linger.
+     */
+    void clear_all_keys();
 };
 
 }  // namespace replicated_splinterdb